@@ -11,19 +11,120 @@
 #include <math.h>
 #include <fcntl.h>
 #include <limits>
+#include <stdint.h>
+#include <vector>
 
 #include "431project.h"
 
 // Data structures to hold simulation result summaries.
 std::pair<double, double> GLOB_baseline_EP_pair;
-std::map<std::string, std::map<std::string, double>*> GLOB_extracted_values;
-std::map<std::string, std::pair<double, double> > GLOB_derived_values;
-std::map<std::string, unsigned int> GLOB_seen_configurations;
+MetricTable GLOB_extracted_values;
 
 void printUsage() {
 	fprintf(stderr,
 			"Wrong number of arguments! Run as './DSE energy' or"
-					" './DSE performance' for energy or performance run, respectively\n");
+					" './DSE performance' for energy or performance run, respectively\n"
+					"or './DSE pareto' for both at once, tracking the Pareto front"
+					" of time and\nenergy (in logs/Pareto.front)\n"
+					"Options:\n"
+					"  -j <workers>  simulations to run in parallel"
+					" (default: one per core)\n"
+					"  -k <depth>    simulate up to depth upcoming proposals"
+					" ahead of time\n"
+					"  -timeout <n>  kill and retry a simulation running n times"
+					" longer than\n"
+					"                similar ones (default 8, 0 for never)\n"
+					"  -budget <n>   search until simulations used n CPU-seconds"
+					" instead of\n"
+					"                1000 proposals; the surrogate then ranks by"
+					" improvement per\n"
+					"                predicted second\n"
+					"  -deadline <n> search for n wall-clock seconds at most,"
+					" likewise\n"
+					"  -s <search>   proposal engine: heuristic (default),"
+					" surrogate or genetic,\n"
+					"                which simulates a generation at a time"
+					" (-k defaults to %u)\n"
+					"  -screen       screen brackets of proposals with shorter"
+					" simulations,\n"
+					"                giving full runs to the best only\n"
+					"  -bound        stop simulating a configuration once a bound"
+					" from its width\n"
+					"                proves it cannot beat the best\n"
+					"  -prune        like -bound, but estimate the benchmarks not"
+					" yet run from\n"
+					"                the recorded ratios between benchmarks; a"
+					" heuristic that\n"
+					"                may drop what would have been the best\n"
+					"  -effects      screen the effect of each dimension first and"
+					" let it order,\n"
+					"                skip or pair the heuristic's sweeps\n"
+					"  -bottleneck   let the stall counters of the best"
+					" configuration order\n"
+					"                the heuristic's sweeps by the bottleneck"
+					" they address\n"
+					"  -offline      replay the surrogate over recorded results,"
+					" report the\n"
+					"                simulations it needs to come within 1%% of"
+					" the best, and exit\n"
+					"  -replay       run the search against recorded results"
+					" only, with a\n"
+					"                stand-in for missing ones, report its"
+					" progress, and exit\n"
+					"  -estimate     estimate the configurations one il1"
+					" dimension away from\n"
+					"                the baseline from captured traces, and"
+					" exit\n"
+					"  -branches     estimate every branch predictor, RAS and BTB"
+					" setting on the\n"
+					"                baseline from captured traces, simulate the"
+					" best few, and exit\n"
+					"  -rank <n>     print the n best recorded configurations"
+					" and exit\n"
+					"An interrupted search continues from logs/<target>.journal"
+					" when run again\n"
+					"with the same options.\n", GENETIC_POPULATION);
+}
+
+/*
+ * Parse an option argument as a whole: parsecount() a decimal integer in
+ * [low, high], parseamount() a finite number of at least 0. Both return 0
+ * and leave value alone on anything else.
+ */
+static int parsecount(const char* text, long low, long high, long& value) {
+	char* end;
+	long parsed = strtol(text, &end, 10);
+	if (*end || end == text || parsed < low || parsed > high) {
+		return 0;
+	}
+	value = parsed;
+	return 1;
+}
+
+static int parseamount(const char* text, double& value) {
+	char* end;
+	double parsed = strtod(text, &end);
+	if (*end || end == text || !(parsed >= 0 && parsed < HUGE_VAL)) {
+		return 0;
+	}
+	value = parsed;
+	return 1;
+}
+
+/*
+ * Journals the search state as it stands before iteration, with the
+ * configurations used up since the last record.
+ */
+static void recordprogress(SearchProgress& progress, unsigned int iteration,
+		std::ofstream& logfile) {
+	logfile.flush();
+	progress.iteration = iteration;
+	progress.screeningspent = GLOB_screening_spent;
+	progress.simulationspent = GLOB_simulation_spent;
+	progress.logbytes = logfile.tellp();
+	progress.explorer = saveExplorerState();
+	journalprogress(progress);
+	progress.seen.clear();
 }
 
 int main(int argc, char** argv) {
@@ -33,33 +134,182 @@ int main(int argc, char** argv) {
 
 	int optimizeforEDP = 0;
 	int optimizeforEXEC = 0;
+	unsigned int workers = 0;
+	unsigned int rankcount = 0;
+	ProposalEngine propose = NULL;
+	ProposalPeek peek = NULL;
+	unsigned int lookahead = 0;
+	int offline = 0;
+	int estimate = 0;
+	int branches = 0;
+	int replay = 0;
+	int pareto = 0;
+	int screen = 0;
+	int prune = 0; // 1 by the width bound, 2 by benchmark ratios as well
+	int effects = 0;
+	int bottleneck = 0;
+	double budget = 0;
+	double deadline = 0;
+	int resumed = 0;
+	std::string search = "heuristic";
+	std::string target;
+	std::string logpath;
+	std::string journalpath;
+	std::string options; // search engine and flags, as journaled
+	SearchProgress progress;
 
 	srand(0); // for stability during testing
+#ifdef DSE_BENCH
+	return runbenchmarks(argc, argv);
+#endif
+#ifdef DSE_TEST
+	return runtests(argc, argv);
+#endif
 
-	if (2 != argc) {
+	if (2 > argc) {
 		printUsage();
 		return -1;
 	} else {
+		pareto = (std::string("pareto") == argv[1]);
 		int isEarg = ('e' == argv[1][0]);
-		int isParg = ('p' == argv[1][0]);
-		if (!(isEarg || isParg)) {
+		int isParg = ('p' == argv[1][0]) && !pareto;
+		if (!(isEarg || isParg || pareto)) {
+			printUsage();
+			return -1;
+		}
+		const long countmax = std::numeric_limits<int>::max();
+		for (int arg = 2; arg < argc; ++arg) {
+			std::string option = argv[arg];
+			long count;
+			if ("-j" == option && arg + 1 < argc) {
+				// one per core is the default
+				if (!parsecount(argv[++arg], 1, countmax, count)) {
+					printUsage();
+					return -1;
+				}
+				workers = count;
+			} else if ("-k" == option && arg + 1 < argc) {
+				if (!parsecount(argv[++arg], 0, countmax, count)) {
+					printUsage();
+					return -1;
+				}
+				lookahead = count;
+			} else if (("-timeout" == option || "-budget" == option
+					|| "-deadline" == option) && arg + 1 < argc) {
+				double& amount = ("-timeout" == option) ?
+						GLOB_simulation_timeout :
+						("-budget" == option) ? budget : deadline;
+				if (!parseamount(argv[++arg], amount)) {
+					printUsage();
+					return -1;
+				}
+			} else if ("-s" == option && arg + 1 < argc) {
+				search = argv[++arg];
+			} else if ("-screen" == option) {
+				screen = 1;
+			} else if ("-bound" == option) {
+				prune = std::max(prune, 1);
+			} else if ("-prune" == option) {
+				prune = 2;
+			} else if ("-effects" == option) {
+				effects = 1;
+			} else if ("-bottleneck" == option) {
+				bottleneck = 1;
+			} else if ("-replay" == option) {
+				replay = 1;
+			} else if ("-estimate" == option) {
+				estimate = 1;
+			} else if ("-branches" == option) {
+				branches = 1;
+			} else if ("-offline" == option) {
+				offline = 1;
+			} else if ("-rank" == option && arg + 1 < argc) {
+				if (!parsecount(argv[++arg], 1, countmax, count)) {
+					printUsage();
+					return -1;
+				}
+				rankcount = count;
+			} else {
+				printUsage();
+				return -1;
+			}
+		}
+		if (pareto && prune) { // the bound prunes on one objective alone
+			printUsage();
+			return -1;
+		}
+		if ((effects || bottleneck) && "heuristic" != search) {
+			// they plan the heuristic's sweeps, and only one of them may
 			printUsage();
 			return -1;
+		}
+		if (effects && bottleneck) {
+			printUsage();
+			return -1;
+		}
+		if ("heuristic" == search) {
+			propose = generateNextConfigurationProposal;
+			peek = peekConfigurationProposals;
+		} else if ("surrogate" == search) {
+			propose = generateSurrogateProposal;
+			peek = peekSurrogateProposals;
+		} else if ("genetic" == search) {
+			propose = generateGeneticProposal;
+			peek = peekGeneticProposals;
+			if (!lookahead) { // the rest of each generation runs alongside
+				lookahead = GENETIC_POPULATION;
+			}
 		} else {
-			system("mkdir -p logs");
-			system("mkdir -p summaryfiles");
-			system("mkdir -p rawProjectOutputData");
-			if (isParg) { // do performance exploration
-				optimizeforEXEC = 1;
-				logfile.open("logs/ExecutionTime.log");
-				bestfile.open("logs/ExecutionTime.best");
-			} else { // do energy-efficiency exploration
-				optimizeforEDP = 1;
-				logfile.open("logs/EnergyEfficiency.log");
-				bestfile.open("logs/EnergyEfficiency.best");
+			printUsage();
+			return -1;
+		}
+		system("mkdir -p logs");
+		system("mkdir -p rawProjectOutputData");
+		if (pareto) { // both; the objective alternates per proposal
+			optimizeforEDP = 1;
+			target = "Pareto";
+		} else if (isParg) { // do performance exploration
+			optimizeforEXEC = 1;
+			target = "ExecutionTime";
+		} else { // do energy-efficiency exploration
+			optimizeforEDP = 1;
+			target = "EnergyEfficiency";
+		}
+		options = search + (screen ? " -screen" : "")
+				+ (prune ? (2 == prune ? " -prune" : " -bound") : "")
+				+ (effects ? " -effects" : "")
+				+ (bottleneck ? " -bottleneck" : "");
+		logpath = "logs/" + target + ".log";
+		journalpath = "logs/" + target + ".journal";
+		if (!(estimate || branches || offline || rankcount || replay)) {
+			// a search, maybe unfinished; the other modes leave the logs be
+			resumed = openjournal(journalpath, target + " " + options,
+					progress);
+			if (resumed) { // keep the log up to the last journaled iteration
+				truncate(logpath.c_str(), progress.logbytes);
+				logfile.open(logpath.c_str(),
+						std::ios::out | std::ios::app | std::ios::ate);
+			} else {
+				logfile.open(logpath.c_str());
 			}
+			bestfile.open(("logs/" + (pareto ? "EnergyEfficiency" : target)
+					+ ".best").c_str());
 		}
 	}
+	setsimulationworkers(workers);
+	setsearchbudget(budget, deadline);
+	if (logfile.is_open()) { // searches only
+		opentelemetry("logs/" + target + ".telemetry", target, options,
+				resumed);
+	}
+	if (0 != openresultstore(GLOB_storefile)) {
+		return -1;
+	}
+	if (0 == storedconfigurations()) { // first run: take in earlier results
+		std::cerr << "Importing results into " << GLOB_storefile << ": "
+				<< importresults(GLOB_simulation_workers)
+				<< " configurations" << std::endl;
+	}
 
 	std::cout << "Testing baseline: ";
 	runexperiments(GLOB_baseline, 0); // generate baseline values
@@ -68,28 +318,153 @@ int main(int argc, char** argv) {
 	GLOB_baseline_EP_pair.first = calculategeomeanEDP(GLOB_baseline);
 	GLOB_baseline_EP_pair.second = calculategeomeanExecutionTime(GLOB_baseline);
 
-	logfile << calculategeomeanEDP(GLOB_baseline) / GLOB_baseline_EP_pair.first
-			<< ","
-			<< calculategeomeanExecutionTime(GLOB_baseline)
-					/ GLOB_baseline_EP_pair.second << ","
-			<< calculategeomeanEDP(GLOB_baseline) << ","
-			<< calculategeomeanExecutionTime(GLOB_baseline) << std::endl;
+	if (!resumed) {
+		logfile << calculategeomeanEDP(GLOB_baseline)
+				/ GLOB_baseline_EP_pair.first << ","
+				<< calculategeomeanExecutionTime(GLOB_baseline)
+						/ GLOB_baseline_EP_pair.second << ","
+				<< calculategeomeanEDP(GLOB_baseline) << ","
+				<< calculategeomeanExecutionTime(GLOB_baseline) << std::endl;
+	}
 	std::cout << std::endl;
 
-	// Prepare for main loop.
-	std::cout << "Starting DSE" << std::endl << std::endl;
-	double bestEDP = GLOB_baseline_EP_pair.first;
-	double bestTime = GLOB_baseline_EP_pair.second;
+	if (estimate) { // trace-driven cache estimates only
+		loadtraces();
+		printcacheestimates(std::cout, packconfiguration(GLOB_baseline));
+		closeresultstore();
+		return 0;
+	}
 
-	std::string bestTimeconfig = GLOB_baseline;
-	std::string bestEDPconfig = GLOB_baseline;
-	std::string currentConfiguration = GLOB_baseline;
+	if (branches) { // trace-driven branch estimates, the best few simulated
+		loadbranchtraces();
+		printbranchestimates(std::cout, packconfiguration(GLOB_baseline),
+				optimizeforEDP);
+		drainexperiments();
+		closeresultstore();
+		return 0;
+	}
 
-	for (unsigned int iter = 0; iter < 1000; ++iter) {
+	if (replay) { // the search against recorded results only
+		replaysearch(std::cout, propose, search, optimizeforEDP, logpath);
+		closeresultstore();
+		return 0;
+	}
+
+	if (offline) { // measure the surrogate against recorded results only
+		evaluatesurrogate(std::cout, optimizeforEDP);
+		closeresultstore();
+		return 0;
+	}
 
-		std::string nextconf = generateNextConfigurationProposal(
-				currentConfiguration, bestTimeconfig, bestEDPconfig,
-				optimizeforEXEC, optimizeforEDP);
+	if (rankcount) { // re-rank recorded results only, no exploration
+		printranking(std::cout, optimizeforEDP, rankcount);
+		closeresultstore();
+		return 0;
+	}
+
+	if (effects) { // recomputed from the store on resume, charged once
+		GLOB_screening_spent += screeneffects(std::cout,
+				optimizeforEDP || pareto, optimizeforEXEC || pareto);
+	}
+
+	if (bottleneck) { // replanned from the best at every traversal
+		preparebottlenecks(optimizeforEDP || pareto);
+		std::vector<SweepStep> plan;
+		if (bottleneckplan(packconfiguration(GLOB_baseline), plan)) {
+			setsweepplan(plan);
+		}
+		setsweepplanner(bottleneckplan);
+	}
+
+	// Prepare for main loop.
+	if (resumed) {
+		if (!restoreExplorerState(progress.explorer)) {
+			std::cerr << "Journaled explorer state is invalid; the traversal"
+					<< " starts over" << std::endl;
+		}
+		std::cout << "Resuming DSE at iteration " << progress.iteration
+				<< " from " << journalpath << std::endl << std::endl;
+		GLOB_screening_spent = progress.screeningspent;
+		GLOB_simulation_spent += progress.simulationspent;
+		populate(progress.bestTimeconfig);
+		populate(progress.bestEDPconfig);
+		std::vector<ConfigId> stored;
+		storedconfigurationids(stored);
+		for (size_t n = 0; pareto && n < stored.size(); ++n) {
+			// the front is every configuration evaluated before the restart
+			if (isconfigurationseen(stored[n])
+					&& isconfigurationsimulated(stored[n])) {
+				populate(unpackconfiguration(stored[n]));
+				updateparetofront(stored[n]);
+			}
+		}
+	} else {
+		std::cout << "Starting DSE" << std::endl << std::endl;
+		progress.iteration = 0;
+		progress.bestEDP = GLOB_baseline_EP_pair.first;
+		progress.bestTime = GLOB_baseline_EP_pair.second;
+		progress.bestTimeconfig = GLOB_baseline;
+		progress.bestEDPconfig = GLOB_baseline;
+		progress.current = GLOB_baseline;
+	}
+	double& bestEDP = progress.bestEDP;
+	double& bestTime = progress.bestTime;
+	std::string& bestTimeconfig = progress.bestTimeconfig;
+	std::string& bestEDPconfig = progress.bestEDPconfig;
+	std::string& currentConfiguration = progress.current;
+	std::vector<std::string>& finalists = progress.finalists;
+	std::vector<std::string> speculated; // upcoming proposals queued ahead
+	if (prune) {
+		preparebounds(optimizeforEDP, 2 == prune);
+	}
+	if (pareto) {
+		updateparetofront(packconfiguration(GLOB_baseline));
+	}
+
+	// Screening runs count against the budget in full-run equivalents. A
+	// budget in seconds replaces the proposal count.
+	for (unsigned int iter = progress.iteration;
+			budgetedsearch() ?
+					withinbudget() : iter + GLOB_screening_spent < 1000;
+			++iter) {
+
+		double lap = telemetryclock();
+		if (pareto) { // steer toward both ends of the front in turn
+			optimizeforEDP = (0 == iter % 2);
+			optimizeforEXEC = !optimizeforEDP;
+		}
+		std::string nextconf = currentConfiguration;
+		if (!screen) {
+			nextconf = propose(currentConfiguration, bestTimeconfig,
+					bestEDPconfig, optimizeforEXEC, optimizeforEDP);
+		}
+		while (screen && finalists.empty()) {
+			std::string first = propose(currentConfiguration, bestTimeconfig,
+					bestEDPconfig, optimizeforEXEC, optimizeforEDP);
+			if (currentConfiguration == first) {
+				break;
+			}
+			std::vector<std::string> bracket;
+			peek(first, bestTimeconfig, bestEDPconfig, optimizeforEXEC,
+					optimizeforEDP, SCREEN_BRACKET - 1, bracket);
+			bracket.insert(bracket.begin(), first);
+			for (unsigned int k = 0; k < bracket.size(); ++k) {
+				markconfigurationseen(packconfiguration(bracket[k]));
+			}
+			std::vector<std::string> screened(bracket);
+			lap = telemetrylap(PHASE_PROPOSE, lap);
+			screenconfigurations(screened, optimizeforEDP);
+			lap = telemetrylap(PHASE_SCREEN, lap);
+			finalists.swap(screened);
+			for (unsigned int k = 0; k < bracket.size(); ++k) {
+				progress.seen.push_back(bracket[k]);
+			}
+			recordprogress(progress, iter, logfile);
+		}
+		if (!finalists.empty()) {
+			nextconf = finalists.front();
+			finalists.erase(finalists.begin());
+		}
 
 		if(currentConfiguration == nextconf) {
 			std::cerr << "returned the same configuration\n"
@@ -97,20 +472,75 @@ int main(int argc, char** argv) {
 			break;
 		}
 
-		runexperiments(nextconf, iter);
+		// Speculatively queue the proposals expected to follow, so they run
+		// while this one is simulated and scored. Every job counts against the
+		// budget, so the queued jobs of proposals no longer expected, after the
+		// best changed, are parked until proposed after all.
+		if (lookahead) {
+			std::vector<std::string> upcoming;
+			peek(nextconf, bestTimeconfig, bestEDPconfig, optimizeforEXEC,
+					optimizeforEDP, lookahead, upcoming);
+			// under screening, upcoming proposals start at the shortest window
+			unsigned int window = screen ? NUM_FIDELITIES - 1 : 0;
+			for (size_t k = 0; k < speculated.size(); ++k) {
+				if (speculated[k] != nextconf
+						&& upcoming.end()
+								== std::find(upcoming.begin(), upcoming.end(),
+										speculated[k])) {
+					parkexperiments(speculated[k], window);
+				}
+			}
+			for (unsigned int k = 0; k < upcoming.size(); ++k) {
+				submitexperiments(upcoming[k], k + 1, window);
+			}
+			speculated.swap(upcoming);
+		}
+		lap = telemetrylap(PHASE_PROPOSE, lap);
+
+		int cached = isconfigurationsimulated(packconfiguration(nextconf));
+		double bound;
+		if (prune
+				&& RUN_PRUNED
+						== runbounded(nextconf, iter,
+								optimizeforEDP ? bestEDP : bestTime,
+								optimizeforEDP, &bound)) {
+			// Not a failure: it counts, but is taken not to become the best.
+			// Only stdout and the telemetry record it; the log keeps the
+			// measured proposals.
+			std::cout << (2 == prune ? " : pruned by estimate " :
+					" : pruned by bound ") << bound << std::endl << std::endl;
+			telemetrylap(PHASE_SIMULATE, lap);
+			telemetryiteration(iter, nextconf, OUTCOME_PRUNED);
+			markconfigurationseen(packconfiguration(nextconf));
+			progress.seen.push_back(nextconf);
+			currentConfiguration = nextconf;
+			recordprogress(progress, iter + 1, logfile);
+			continue;
+		} else if (!prune) {
+			runexperiments(nextconf, iter);
+		}
+		lap = telemetrylap(PHASE_SIMULATE, lap);
 		populate(nextconf);
+		lap = telemetrylap(PHASE_POPULATE, lap);
+		progress.seen.push_back(nextconf); // journaled with the next progress
 
-		if (0
-				== (*(GLOB_extracted_values[nextconf]))[GLOB_prefixes[0]
-						+ GLOB_fields[0]]) { // quick and dirty sanity check
+		ConfigId nextid = packconfiguration(nextconf);
+		int broken = 0; // quick and dirty sanity check, on every benchmark
+		for (int i = 0; i < 5; ++i) {
+			broken = broken
+					|| 0 == GLOB_extracted_values[nextid].values[i][FIELD_SIM_NUM_INSN];
+		}
+		if (broken) {
 			// run failed, try another, don't count this one
 			std::cout << " [failed] " << std::endl;
+			telemetryiteration(iter, nextconf, OUTCOME_FAILED);
 			--iter;
 			continue;
 		}
 
-		double proposedGeoEDP = calculategeomeanEDP(nextconf);
-		double proposedGeoTime = calculategeomeanExecutionTime(nextconf);
+		double proposedGeoEDP = calculategeomeanEDP(nextid);
+		double proposedGeoTime = calculategeomeanExecutionTime(nextid);
+		telemetrylap(PHASE_EVALUATE, lap);
 		double geomeanEDPNorm = proposedGeoEDP / GLOB_baseline_EP_pair.first;
 		double geomeanExecTimeNorm = proposedGeoTime
 				/ GLOB_baseline_EP_pair.second;
@@ -132,16 +562,28 @@ int main(int argc, char** argv) {
 				<< proposedGeoEDP << ", bestEDP=" << bestEDP
 				<< ", proposedGeoTime=" << proposedGeoTime << ", bestTime="
 				<< bestTime;
+		if (pareto) {
+			updateparetofront(nextid);
+			std::cout << ", front=" << paretofrontsize();
+		}
 
 		// Get ready for next iteration.
 		std::cout << std::endl << std::endl;
+		if (budgetedsearch()) {
+			printbudgetprojection(std::cout);
+			std::cout << std::endl;
+		}
 		currentConfiguration = nextconf;
+		telemetryiteration(iter, nextconf,
+				cached ? OUTCOME_FOUND : OUTCOME_SIMULATED);
+		recordprogress(progress, iter + 1, logfile);
 	}
 
 	// Dump best configurations stats and associated data to bestfile.
+	std::stringstream best;
 
 	// Dump best EDP config geomean and all 5 individual benchmark stats.
-	bestfile << bestEDPconfig << ","
+	best << bestEDPconfig << ","
 			<< calculategeomeanEDP(bestEDPconfig) / GLOB_baseline_EP_pair.first
 			<< ","
 			<< calculategeomeanExecutionTime(bestEDPconfig)
@@ -149,14 +591,14 @@ int main(int argc, char** argv) {
 			<< calculategeomeanEDP(bestEDPconfig) << ","
 			<< calculategeomeanExecutionTime(bestEDPconfig) << ",";
 	for (int i = 0; i < 5; ++i) {
-		bestfile << calculateEDP(bestEDPconfig, GLOB_prefixes[i]) << ","
+		best << calculateEDP(bestEDPconfig, GLOB_prefixes[i]) << ","
 				<< calculateEDP(bestEDPconfig, GLOB_prefixes[i])
 						/ calculateEDP(GLOB_baseline, GLOB_prefixes[i]) << ",";
 	}
-	bestfile << std::endl;
+	best << std::endl;
 
 	// Dump best Execution Time config geomean and all 5 individual benchmark stats.
-	bestfile << bestTimeconfig << ","
+	best << bestTimeconfig << ","
 			<< calculategeomeanEDP(bestTimeconfig) / GLOB_baseline_EP_pair.first
 			<< ","
 			<< calculategeomeanExecutionTime(bestTimeconfig)
@@ -164,14 +606,40 @@ int main(int argc, char** argv) {
 			<< calculategeomeanEDP(bestTimeconfig) << ","
 			<< calculategeomeanExecutionTime(bestTimeconfig) << ",";
 	for (int i = 0; i < 5; ++i) {
-		bestfile << calculateExecutionTime(bestTimeconfig, GLOB_prefixes[i])
+		best << calculateExecutionTime(bestTimeconfig, GLOB_prefixes[i])
 				<< ","
 				<< calculateExecutionTime(bestTimeconfig, GLOB_prefixes[i])
 						/ calculateExecutionTime(GLOB_baseline,
 								GLOB_prefixes[i]) << ",";
 	}
-	bestfile << std::endl;
+	best << std::endl;
+
+	bestfile << best.str();
+	if (pareto) { // one campaign, both targets
+		std::ofstream timebestfile("logs/ExecutionTime.best");
+		timebestfile << best.str();
+		std::ofstream frontfile("logs/Pareto.front");
+		printparetofront(frontfile);
+	}
+
+	if (effects) {
+		printeffectssavings(std::cout);
+	}
+	if (bottleneck) {
+		printbottlenecksavings(std::cout);
+	}
+	if (budgetedsearch()) {
+		printbudgetsummary(std::cout);
+	}
+	std::cerr << "Simulations saved by equivalent configurations: "
+			<< equivalentreuses() << std::endl;
+	printjobtails(std::cerr);
 
 	logfile.close();
+	printsearchquality(std::cerr, target, search, optimizeforEDP || pareto);
 	bestfile.close();
+	closejournal(1);
+	closetelemetry();
+	drainexperiments();
+	closeresultstore();
 }
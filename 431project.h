@@ -13,11 +13,200 @@ const std::string GLOB_fields[7] = { "sim_num_insn ", "sim_cycle ",
 		"il1.accesses ", "dl1.accesses ", "ul2.accesses ", "ul2.misses ",
 		"ul2.writebacks " };
 const std::string GLOB_prefixes[5] = { "0.", "1.", "2.", "3.", "4." };
+const int NUM_BENCHMARKS = 5;
+const int NUM_FIELDS = 7;
+
+/*
+ * Indices into GLOB_fields.
+ */
+enum {
+	FIELD_SIM_NUM_INSN = 0,
+	FIELD_SIM_CYCLE,
+	FIELD_IL1_ACCESSES,
+	FIELD_DL1_ACCESSES,
+	FIELD_UL2_ACCESSES,
+	FIELD_UL2_MISSES,
+	FIELD_UL2_WRITEBACKS
+};
+
+/*
+ * Packed configuration. Dimension d takes the fewest bits that hold its
+ * cardinality (GLOB_dimensionbits[d]), 50 bits in all, with dimension 0 most
+ * significant so ConfigIds sort like configuration strings.
+ */
+typedef uint64_t ConfigId;
+const ConfigId NO_CONFIG = ~(ConfigId) 0;
+const unsigned int GLOB_dimensionbits[NUM_DIMS] = { 2, 1, 2, 4, 2, 4, 2, 4, 2,
+		3, 2, 2, 3, 2, 3, 4, 4, 4 };
+const unsigned int GLOB_dimensionshift[NUM_DIMS] = { 48, 47, 45, 41, 39, 35,
+		33, 29, 27, 24, 22, 20, 17, 15, 12, 8, 4, 0 };
+
+inline unsigned int configparam(ConfigId id, int dim) {
+	return (id >> GLOB_dimensionshift[dim])
+			& ((1u << GLOB_dimensionbits[dim]) - 1);
+}
+
+inline ConfigId setconfigparam(ConfigId id, int dim, unsigned int value) {
+	ConfigId mask = (ConfigId) ((1u << GLOB_dimensionbits[dim]) - 1)
+			<< GLOB_dimensionshift[dim];
+	return (id & ~mask) | ((ConfigId) value << GLOB_dimensionshift[dim]);
+}
+
+/*
+ * Simulation fidelity, kept in the bits above the configuration. Level 0 is
+ * the full window, so a ConfigId without a level stands for full results;
+ * screening level l simulates GLOB_fidelityinsts[l] instructions per
+ * benchmark. The result store and GLOB_extracted_values keep every level
+ * apart.
+ */
+const int NUM_FIDELITIES = 3;
+const unsigned int GLOB_fidelityinsts[NUM_FIDELITIES] = { 1000000, 300000,
+		100000 };
+const unsigned int FIDELITY_SHIFT = 56;
+
+inline unsigned int configfidelity(ConfigId id) {
+	return (id >> FIDELITY_SHIFT) & 0xf;
+}
+
+inline ConfigId setconfigfidelity(ConfigId id, unsigned int level) {
+	return (id & ~((ConfigId) 0xf << FIDELITY_SHIFT))
+			| ((ConfigId) level << FIDELITY_SHIFT);
+}
+
+/*
+ * Conversions between the "d d d ..." string form and ConfigId. Packing is
+ * exact for strings that pass isNumDimConfiguration().
+ */
+ConfigId packconfiguration(const std::string& configuration);
+std::string unpackconfiguration(ConfigId id);
+
+/*
+ * Extracted counters of one configuration, indexed by benchmark and FIELD_*.
+ */
+struct ConfigMetrics {
+	double values[NUM_BENCHMARKS][NUM_FIELDS];
+	unsigned int benchmarks; // bit i: values[i] hold a clean result
+};
+
+inline size_t hashconfiguration(ConfigId id) {
+	id ^= id >> 33; // murmur3 finaliser
+	id *= 0xff51afd7ed558ccdULL;
+	id ^= id >> 33;
+	id *= 0xc4ceb9fe1a85ec53ULL;
+	id ^= id >> 33;
+	return id;
+}
+
+/*
+ * Flat open-addressing hash table from ConfigId to a plain struct. Pointers
+ * returned stay valid until the next insertion. Iterate by scanning keys for
+ * entries other than NO_CONFIG.
+ */
+template<class T>
+struct ConfigTable {
+	std::vector<ConfigId> keys; // NO_CONFIG marks a free slot
+	std::vector<T> values;
+	size_t entries;
+
+	ConfigTable() :
+			keys(1024, NO_CONFIG), values(1024), entries(0) {
+	}
+
+	T* find(ConfigId id) {
+		size_t mask = keys.size() - 1;
+		for (size_t slot = hashconfiguration(id) & mask;;
+				slot = (slot + 1) & mask) {
+			if (id == keys[slot]) {
+				return &values[slot];
+			}
+			if (NO_CONFIG == keys[slot]) {
+				return NULL;
+			}
+		}
+	}
+
+	T& operator[](ConfigId id) { // inserts a zeroed value
+		T* found = find(id);
+		if (found) {
+			return *found;
+		}
+		if (2 * (entries + 1) > keys.size()) { // keep at most half full
+			std::vector<ConfigId> oldkeys(2 * keys.size(), NO_CONFIG);
+			std::vector<T> oldvalues(2 * keys.size());
+			oldkeys.swap(keys);
+			oldvalues.swap(values);
+			for (size_t i = 0; i < oldkeys.size(); ++i) {
+				if (NO_CONFIG != oldkeys[i]) {
+					size_t slot = freeslot(oldkeys[i]);
+					keys[slot] = oldkeys[i];
+					values[slot] = oldvalues[i];
+				}
+			}
+		}
+		size_t slot = freeslot(id);
+		keys[slot] = id;
+		values[slot] = T();
+		entries++;
+		return values[slot];
+	}
+
+	size_t size() const {
+		return entries;
+	}
+
+private:
+	size_t freeslot(ConfigId id) const {
+		size_t mask = keys.size() - 1;
+		size_t slot = hashconfiguration(id) & mask;
+		while (NO_CONFIG != keys[slot]) {
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+};
+
+typedef ConfigTable<ConfigMetrics> MetricTable;
 
 extern std::pair<double, double> GLOB_baseline_EP_pair;
-extern std::map<std::string, std::map<std::string, double>*> GLOB_extracted_values;
-extern std::map<std::string, std::pair<double, double> > GLOB_derived_values;
-extern std::map<std::string, unsigned int> GLOB_seen_configurations;
+extern MetricTable GLOB_extracted_values;
+
+/*
+ * Energy/time model constants. Sizes are bytes, times seconds, energies
+ * joules, leakage watts. Tables are indexed [scheduling][log2 width] and
+ * cache size class, the last class covering everything above the limits.
+ */
+struct TechnologyParams {
+	double cycletime[2][4];
+	double fpcycletime; // added per FP unit
+	double epci[2][4];
+	double pipelineleak[2][4];
+	double fpleak; // added per FP unit
+	unsigned int cachesizelimit[9];
+	double cacheleak[10];
+	double accessenergy[10];
+	double memoryrefresh;
+	double memoryaccess; // per ul2 miss or writeback
+};
+extern TechnologyParams GLOB_technology;
+
+/*
+ * Memoized geomeans of a configuration, valid while generation equals
+ * GLOB_model_generation.
+ */
+struct DerivedValues {
+	double geomeanEDP;
+	double geomeanTime;
+	unsigned int generation;
+};
+extern unsigned int GLOB_model_generation;
+extern ConfigTable<DerivedValues> GLOB_derived_values;
+
+/*
+ * Cache latency fields ("1 1 1") for the cache geometry of a configuration,
+ * and the project constraints on a whole configuration (1 if valid).
+ */
+std::string generateCacheLatencyParams(std::string halfBackedConfig);
+int validateConfiguration(std::string configuration);
 
 /*
  * Given the current best known configuration, the current configuration,
@@ -29,6 +218,152 @@ std::string generateNextConfigurationProposal(std::string currentconfiguration,
 		std::string bestEXECconfiguration, std::string bestEDPconfiguration,
 		int optimizeforEXEC, int optimizeforEDP);
 
+/*
+ * Appends up to count proposals that generateNextConfigurationProposal() would
+ * make after nextconfiguration, if the best configurations stayed as they
+ * are. Does not advance the heuristic.
+ */
+void peekConfigurationProposals(std::string nextconfiguration,
+		std::string bestEXECconfiguration, std::string bestEDPconfiguration,
+		int optimizeforEXEC, int optimizeforEDP, unsigned int count,
+		std::vector<std::string>& proposals);
+
+/*
+ * Proposal engines, selected with -s.
+ */
+typedef std::string (*ProposalEngine)(std::string currentconfiguration,
+		std::string bestEXECconfiguration, std::string bestEDPconfiguration,
+		int optimizeforEXEC, int optimizeforEDP);
+typedef void (*ProposalPeek)(std::string nextconfiguration,
+		std::string bestEXECconfiguration, std::string bestEDPconfiguration,
+		int optimizeforEXEC, int optimizeforEDP, unsigned int count,
+		std::vector<std::string>& proposals);
+
+/*
+ * Surrogate-guided alternative to the heuristic, with the same interface:
+ * proposes the unseen configuration whose predicted geomean EDP or time,
+ * less an uncertainty bonus, is lowest, training on every complete result.
+ * evaluatesurrogate() replays the search over the recorded results only and
+ * reports how many simulations it needs to come within 1% of the best of them.
+ */
+std::string generateSurrogateProposal(std::string currentconfiguration,
+		std::string bestEXECconfiguration, std::string bestEDPconfiguration,
+		int optimizeforEXEC, int optimizeforEDP);
+void peekSurrogateProposals(std::string nextconfiguration,
+		std::string bestEXECconfiguration, std::string bestEDPconfiguration,
+		int optimizeforEXEC, int optimizeforEDP, unsigned int count,
+		std::vector<std::string>& proposals);
+unsigned int evaluatesurrogate(std::ostream& out, int optimizeforEDP);
+
+/*
+ * Genetic alternative to the heuristic, with the same interface: breeds
+ * generations of GENETIC_POPULATION valid, unseen configurations from the
+ * best ones seen so far by crossover and mutation, and proposes each
+ * generation in turn; the peek returns the rest of the generation, for the
+ * pool to simulate together. geneticgenerations() counts those bred.
+ */
+const unsigned int GENETIC_POPULATION = 32;
+std::string generateGeneticProposal(std::string currentconfiguration,
+		std::string bestEXECconfiguration, std::string bestEDPconfiguration,
+		int optimizeforEXEC, int optimizeforEDP);
+void peekGeneticProposals(std::string nextconfiguration,
+		std::string bestEXECconfiguration, std::string bestEDPconfiguration,
+		int optimizeforEXEC, int optimizeforEDP, unsigned int count,
+		std::vector<std::string>& proposals);
+unsigned int geneticgenerations();
+
+/*
+ * Sweep plan of the heuristic: each step sweeps one dimension, or two jointly
+ * over every pair of their values (partner -1 for none). setsweepplan()
+ * replaces the default, every independent dimension alone in a fixed order,
+ * and restarts the traversal at its first step. heuristictraversals() counts
+ * the traversals begun.
+ */
+struct SweepStep {
+	int dim;
+	int partner;
+};
+void setsweepplan(const std::vector<SweepStep>& plan);
+unsigned int heuristictraversals();
+
+/*
+ * Sweep planner of the heuristic: at the start of every traversal it may
+ * rewrite the plan from the best configuration, returning 1 if it did. The
+ * plan is journaled with the heuristic progress.
+ */
+typedef int (*SweepPlanner)(ConfigId best, std::vector<SweepStep>& plan);
+void setsweepplanner(SweepPlanner planner);
+
+/*
+ * Bottleneck breakdown (-bottleneck). bottleneckshares() splits the cycles of
+ * a configuration, averaged over the benchmarks, into the shares the stall
+ * counters attribute to the front end (il1 misses while the fetch queue is
+ * not full), branch mispredictions, L1D (dl1 and dtlb misses) and L2/memory
+ * (ul2 misses), leaving the rest to issue; it returns the benchmarks it
+ * found stall counters for. bottleneckplan() is a SweepPlanner: categories
+ * by falling share, each sweeping the dimensions that address it, those
+ * below BOTTLENECK_NEGLIGIBLE left out unless they are issue, or cost energy
+ * and EDP is the objective, as set by preparebottlenecks().
+ * printbottlenecksavings() counts the sweep points left out over the
+ * traversals planned.
+ */
+enum {
+	BOTTLENECK_FRONTEND = 0,
+	BOTTLENECK_BRANCH,
+	BOTTLENECK_L1D,
+	BOTTLENECK_MEMORY,
+	BOTTLENECK_ISSUE,
+	NUM_BOTTLENECKS
+};
+const double BOTTLENECK_NEGLIGIBLE = 0.02;
+void preparebottlenecks(int optimizeforEDP);
+unsigned int bottleneckshares(ConfigId id, double shares[NUM_BOTTLENECKS]);
+int bottleneckplan(ConfigId best, std::vector<SweepStep>& plan);
+void printbottlenecksavings(std::ostream& out);
+
+/*
+ * Heuristic progress as a single line of text, for the search journal.
+ * restoreExplorerState() returns 0 and leaves the progress alone if the line
+ * does not parse or indexes past the sweep plan.
+ */
+std::string saveExplorerState();
+int restoreExplorerState(std::string state);
+
+/*
+ * Runs a proposal engine for the full budget against recorded results, with a
+ * deterministic stand-in for configurations the store lacks, and reports the
+ * best normalised EDP and time after so many proposals next to the recorded
+ * run in logpath, the proposals needed to come within 1% of that run's best,
+ * and the engine's CPU time per proposal. Returns the proposals made.
+ */
+unsigned int replaysearch(std::ostream& out, ProposalEngine propose,
+		std::string engine, int optimizeforEDP, std::string logpath);
+
+/*
+ * Keeps the log of a finished search as logs/<target>.<engine>.log and prints
+ * its best normalised EDP or time after so many evaluations next to the last
+ * heuristic search kept there, with the evaluations each needed to come
+ * within 1% of the better of the two.
+ */
+void printsearchquality(std::ostream& out, std::string target,
+		std::string engine, int optimizeforEDP);
+
+#ifdef DSE_BENCH
+/*
+ * Microbenchmarks of the driver, run instead of the search in builds with
+ * DSE_BENCH; argv[1], if given, selects the cases whose name contains it.
+ */
+int runbenchmarks(int argc, char** argv);
+#endif
+
+#ifdef DSE_TEST
+/*
+ * Checks of the driver against recorded results, run instead of the search
+ * in builds with DSE_TEST; returns the number of failed checks.
+ */
+int runtests(int argc, char** argv);
+#endif
+
 /*
  * Runs experiments for a given configuration, if they have not already been
  * run. Stores raw data in globally accessible location. 
@@ -37,18 +372,274 @@ std::string generateNextConfigurationProposal(std::string currentconfiguration,
  */
 int runexperiments(std::string configuration, unsigned int iteration);
 
+/*
+ * Simulation job pool. Each (configuration, benchmark) pair runs as its own
+ * simulator process, at most GLOB_simulation_workers at a time, longest
+ * benchmark first.
+ *
+ * submitexperiments() queues the benchmarks of a configuration missing from
+ * the result store at the given fidelity and returns 1, or returns 0 if none
+ * are missing. Jobs of a lower priority value start first; speculative
+ * submissions use priorities above 0 and are promoted when submitted again or
+ * waited on.
+ * waitexperiments() blocks until the given configuration completes and
+ * returns the number of benchmarks that failed. Proposals overlap only when
+ * the search submits upcoming ones ahead of time (-k).
+ * stepexperiments() waits for the next job of any configuration to finish and
+ * returns 1 while the given configuration is incomplete, 0 once it is done.
+ * parkexperiments() sets the queued jobs of a speculative configuration aside
+ * until it is submitted again or waited on; its running jobs finish.
+ * cancelexperiments() drops the queued jobs of a configuration and kills its
+ * running ones. setbenchmarkorder() dispatches the benchmarks of equal
+ * priority in the given order instead of longest first (NULL restores that).
+ * drainexperiments() drops the jobs not yet started and waits for the rest.
+ * setsimulationworkers(0) uses one worker per online core. Only the pool's
+ * own children are reaped.
+ *
+ * Other DSE processes may share the output directory: a job is only started
+ * once claimed, and a job another process holds waits, without taking a
+ * worker, until that process records it in the store or gives it up.
+ *
+ * A benchmark recorded for an equivalent configuration (see simulationclass())
+ * is copied over instead of simulated; equivalentreuses() counts those.
+ *
+ * A job running GLOB_simulation_timeout times longer than similar ones took
+ * (0 for no limit; none either while its benchmark has no recorded or
+ * measured run) is killed and, like a job that failed, retried after a
+ * backoff; one that keeps failing is quarantined in GLOB_outputpath/quarantine
+ * and from then on counts as failed without running.
+ *
+ * GLOB_simulation_spent sums the CPU-seconds of every job reaped, restored
+ * from the journal on resume.
+ */
+extern unsigned int GLOB_simulation_workers;
+extern double GLOB_simulation_timeout;
+extern double GLOB_simulation_spent;
+extern double GLOB_benchmark_seconds[5];
+void setsimulationworkers(unsigned int workers);
+int isconfigurationsimulated(ConfigId id);
+int submitexperiments(std::string configuration, unsigned int priority = 0,
+		unsigned int fidelity = 0);
+int waitexperiments(std::string configuration, unsigned int fidelity = 0);
+int stepexperiments(std::string configuration, unsigned int fidelity = 0);
+void parkexperiments(std::string configuration, unsigned int fidelity = 0);
+void cancelexperiments(std::string configuration, unsigned int fidelity = 0);
+void setbenchmarkorder(const int* order);
+void drainexperiments();
+unsigned long equivalentreuses();
+
+/*
+ * Simulation cost model and search budgets (-budget, -deadline).
+ * recordsimulationcost() adds the CPU-seconds of a full-window job to a ridge
+ * regression of log seconds, per benchmark, on the core, fpwidth, predictor
+ * and cache sizes of the configuration; it starts from the sim_elapsed_time
+ * of the .simout files on record. predictsimulationseconds() is the predicted
+ * CPU-seconds of the benchmarks of a configuration the store lacks.
+ * setsearchbudget() bounds the search by CPU-seconds of simulation
+ * (GLOB_simulation_spent) and by wall-clock seconds of this run, 0 for no
+ * bound; withinbudget() tells whether another proposal may start, and
+ * budgetedsearch() whether either bound is set. printbudgetprojection(),
+ * called once per proposal, reports the spending so far and when, at its
+ * rate, the budget runs out; printbudgetsummary() the total and how far off
+ * the cost predictions were.
+ */
+void recordsimulationcost(ConfigId id, int benchmark, double seconds);
+double predictsimulationseconds(ConfigId id);
+void setsearchbudget(double cpuseconds, double wallseconds);
+int budgetedsearch();
+int withinbudget();
+void printbudgetprojection(std::ostream& out);
+void printbudgetsummary(std::ostream& out);
+
+/*
+ * Claims on simulation jobs across processes and hosts sharing
+ * GLOB_outputpath, held until released or until the process dies.
+ * claimbenchmark() returns 1 once this process holds the claim on a benchmark
+ * of a configuration at a fidelity, 0 while another process does.
+ * isbenchmarkclaimed() tells whether another process holds it now.
+ */
+int claimbenchmark(std::string configuration, int benchmark,
+		unsigned int fidelity);
+int isbenchmarkclaimed(std::string configuration, int benchmark,
+		unsigned int fidelity);
+void releasebenchmark(std::string configuration, int benchmark,
+		unsigned int fidelity);
+
+/*
+ * Successive halving. screenconfigurations() simulates candidates at the
+ * shortest screening window, keeps the best 1/SCREEN_ETA of them by the
+ * geomean EDP (or time) at that window, moves those to the next longer
+ * window, and so on; the survivors of the longest screening window are left
+ * in candidates for a full run. Candidates whose screening run fails are
+ * dropped. GLOB_screening_spent accumulates the screening runs in full-run
+ * equivalents. Brackets are SCREEN_BRACKET candidates, enough to leave one.
+ */
+const unsigned int SCREEN_ETA = 3;
+const unsigned int SCREEN_BRACKET = 9; // SCREEN_ETA^(NUM_FIDELITIES - 1)
+extern double GLOB_screening_spent;
+void screenconfigurations(std::vector<std::string>& candidates,
+		int optimizeforEDP);
+unsigned int loadscreening(ConfigId id);
+
+/*
+ * Main-effects screening for the heuristic (-effects). screeneffects()
+ * simulates one dimension at a time around the baseline at the shortest
+ * screening window, crosses the strongest dimensions pairwise, prints the
+ * effects on geomean EDP and time, and sets the sweep plan: dimensions by
+ * falling effect on the objectives searched, negligible ones left out,
+ * strongly interacting pairs swept jointly. Returns the cost in full-run
+ * equivalents. printeffectssavings() sets that against the proposals the
+ * plan saved over the traversals so far.
+ */
+double screeneffects(std::ostream& out, int optimizeforEDP,
+		int optimizeforEXEC);
+void printeffectssavings(std::ostream& out);
+
+/*
+ * Branch and bound over the benchmarks of a configuration. preparebounds()
+ * orders the benchmarks by how widely the target metric spreads over the
+ * recorded configurations; with ratios set it also takes the smallest ratios
+ * between benchmarks, which estimate the ones not yet simulated from those
+ * already simulated, a heuristic rather than a bound. runbounded() runs a
+ * configuration like runexperiments(), in that order, and aborts its
+ * remaining simulations once the lower bound on its geomean exceeds best; it
+ * then returns RUN_PRUNED, else the number of failed benchmarks, with the
+ * bound in *bound either way (the geomean itself once all are recorded).
+ * geomeanbound() is that bound for the benchmarks in the mask recorded in
+ * values.
+ */
+const int RUN_PRUNED = -1;
+void preparebounds(int optimizeforEDP, int ratios);
+double geomeanbound(ConfigId id, unsigned int benchmarks,
+		const double values[5][7], int optimizeforEDP);
+int runbounded(std::string configuration, unsigned int iteration, double best,
+		int optimizeforEDP, double* bound);
+
+/*
+ * Search journal, so that a killed search continues where it stopped.
+ * openjournal() returns 1 with the last journaled progress if path holds an
+ * unfinished search started with the same header, after marking everything it
+ * had seen; otherwise it starts a new journal and returns 0.
+ * journalprogress() appends one line with the progress and the
+ * configurations seen since the last one, and syncs it. closejournal(1) marks
+ * the search finished, so the next run starts over.
+ */
+struct SearchProgress {
+	unsigned int iteration; // next one to run
+	double screeningspent; // GLOB_screening_spent
+	double simulationspent; // GLOB_simulation_spent
+	long logbytes; // size of the log file, anything past it is dropped
+	std::string current;
+	std::string bestTimeconfig;
+	double bestTime;
+	std::string bestEDPconfig;
+	double bestEDP;
+	std::string explorer; // saveExplorerState()
+	std::vector<std::string> finalists; // screened, waiting for a full run
+	std::vector<std::string> seen; // used up since the last journaled progress
+};
+int openjournal(std::string path, std::string header,
+		SearchProgress& progress);
+void journalprogress(const SearchProgress& progress);
+void closejournal(int finished);
+
+/*
+ * Search telemetry: JSON lines with the seconds each iteration spent per
+ * phase, every simulation job, and a closing summary. telemetrylap() adds the
+ * time since since to a phase of the current iteration and returns the
+ * clock; telemetryiteration() writes the iteration and starts the next one.
+ * telemetryjob() takes a JOB_ outcome and the attempt, 0 for a first run.
+ * Nothing is written until opentelemetry(), but job times are kept anyway for
+ * printjobtails(), which tabulates their percentiles per benchmark.
+ */
+enum {
+	PHASE_PROPOSE = 0,
+	PHASE_SCREEN,
+	PHASE_SIMULATE,
+	PHASE_POPULATE,
+	PHASE_EVALUATE,
+	NUM_PHASES
+};
+enum {
+	OUTCOME_FOUND = 0, // "found in file"
+	OUTCOME_SIMULATED,
+	OUTCOME_PRUNED,
+	OUTCOME_FAILED,
+	NUM_OUTCOMES
+};
+enum {
+	JOB_OK = 0, JOB_FAILED, JOB_TIMEDOUT
+};
+void opentelemetry(std::string path, std::string target, std::string search,
+		int resumed);
+double telemetryclock();
+double telemetrylap(int phase, double since);
+void telemetryjob(std::string configuration, int benchmark,
+		unsigned int fidelity, double seconds, int outcome,
+		unsigned int attempt, const double speed[2]);
+void telemetryiteration(unsigned int iteration, std::string configuration,
+		int outcome);
+void closetelemetry();
+void printjobtails(std::ostream& out);
+
+/*
+ * Pareto front of geomean execution time and geomean energy over the
+ * configurations evaluated, for "./DSE pareto". updateparetofront() adds a
+ * loaded configuration and returns 1 if it is on the front;
+ * printparetofront() writes the front by increasing time as CSV lines of
+ * configuration, time, energy, and both normalised to the baseline.
+ */
+int updateparetofront(ConfigId id);
+unsigned int paretofrontsize();
+void printparetofront(std::ostream& out);
+
 /*
  * Uses pre-populated in-memory structure to calculate the execution time 
  * a given benchmark+configuration run.
  */
-double calculateExecutionTime(std::string configuration,
-		std::string benchmarkprefix);
-double calculategeomeanExecutionTime(std::string configuration);
+double calculateExecutionTime(ConfigId id, int benchmark);
+double calculategeomeanExecutionTime(ConfigId id);
 
 /*
  * Uses pre-populated in-memory structure to calculate the execution time for 
  * a given benchmark+configuration run.
  */
+double calculateEDP(ConfigId id, int benchmark);
+double calculategeomeanEDP(ConfigId id);
+
+/*
+ * Batch evaluation over columns of configurations and their counters.
+ * evaluatebatch() fills time, edp and the geomeans for every configuration
+ * added and, unless memoize is 0 (counters that are not measurements),
+ * memoizes the geomeans in GLOB_derived_values.
+ * evaluatehistory() does so for every complete configuration in the result
+ * store; printranking() prints the best count of them, by EDP or time.
+ * settechnology() installs new model constants and invalidates every
+ * memoized value; invalidatederivedvalues() drops one configuration.
+ */
+struct EvaluationBatch {
+	std::vector<ConfigId> ids;
+	std::vector<double> counters[NUM_BENCHMARKS][NUM_FIELDS];
+	std::vector<double> time[NUM_BENCHMARKS];
+	std::vector<double> edp[NUM_BENCHMARKS];
+	std::vector<double> geomeanTime;
+	std::vector<double> geomeanEDP;
+
+	void add(ConfigId id, const ConfigMetrics& metrics);
+	void clear();
+};
+void evaluatebatch(EvaluationBatch& batch, int memoize = 1);
+unsigned int evaluatehistory(EvaluationBatch& batch);
+void printranking(std::ostream& out, int optimizeforEDP, unsigned int count);
+void settechnology(const TechnologyParams& params);
+void invalidatederivedvalues(ConfigId id);
+
+/*
+ * String forms of the above, for logging and older callers.
+ */
+double calculateExecutionTime(std::string configuration,
+		std::string benchmarkprefix);
+double calculategeomeanExecutionTime(std::string configuration);
 double calculateEDP(std::string configuration, std::string benchmarkprefix);
 double calculategeomeanEDP(std::string configuration);
 
@@ -60,23 +651,197 @@ double calculategeomeanEDP(std::string configuration);
  */
 int isNumDimConfiguration(std::string configuration);
 
+/*
+ * Design space of valid configurations: those meeting the project
+ * constraints, with the cache latencies derived from the cache geometry.
+ *
+ * isvalidconfiguration() checks the constraints on a packed configuration;
+ * setcachelatencies() fills in its dependent dimensions.
+ * rankconfiguration() numbers a valid configuration in ConfigId order, from 0
+ * to validconfigurations() - 1, and unrankconfiguration() inverts it.
+ * sampleconfiguration() draws one uniformly using rand().
+ * validneighbours() appends the valid configurations that differ in exactly
+ * one independent dimension. The seen set, kept by populate(), is a bitmap
+ * over ranks.
+ * simulationclass() maps a configuration to the representative of those whose
+ * simulation of a benchmark gives the same counters (the dimensions it ignores
+ * set to 0), and equivalentconfigurations() appends every member of that
+ * class, the representative first. Energy and time still differ by member.
+ */
+int isvalidconfiguration(ConfigId id);
+ConfigId setcachelatencies(ConfigId id);
+uint64_t validconfigurations();
+uint64_t rankconfiguration(ConfigId id);
+ConfigId unrankconfiguration(uint64_t rank);
+ConfigId sampleconfiguration();
+void validneighbours(ConfigId id, std::vector<ConfigId>& neighbours);
+ConfigId simulationclass(ConfigId id, int benchmark);
+void equivalentconfigurations(ConfigId id, int benchmark,
+		std::vector<ConfigId>& members);
+void markconfigurationseen(ConfigId id);
+int isconfigurationseen(ConfigId id);
+uint64_t seenconfigurations();
+
 /*
  * Retrieves data from raw result files and places it in an in-memory data
  * structure.
  */
 void populate(std::string configuration);
 
+/*
+ * Reads the GLOB_fields values of one .simout file into values[], in
+ * GLOB_fields order, with a single pass over a read-only mapping of the file.
+ * Returns SIMOUT_OK, or the reason the file is unusable with details in error.
+ * Fields reported as "<error: divide by zero>" count as missing. If speed is
+ * not NULL it receives sim_elapsed_time and sim_inst_rate, 0 when absent.
+ */
+enum {
+	SIMOUT_OK = 0, SIMOUT_MISSING, SIMOUT_TRUNCATED, SIMOUT_INCOMPLETE
+};
+int parsesimout(std::string path, double values[7], std::string& error,
+		double speed[2] = NULL);
+
+/*
+ * Stall counters sim-outorder reports next to GLOB_fields, which the result
+ * store does not keep: queue full fractions, miss rates, the predictor's
+ * mispredictions (bpred_<predictor>.misses) and dtlb misses. parsestalls()
+ * reads them from the full-window .simout of a benchmark in the same way;
+ * it returns 1 if all were there.
+ */
+enum {
+	STALL_IFQ_FULL = 0,
+	STALL_RUU_FULL,
+	STALL_LSQ_FULL,
+	STALL_IL1_MISS_RATE,
+	STALL_DL1_MISS_RATE,
+	STALL_UL2_MISS_RATE,
+	STALL_BPRED_MISSES,
+	STALL_DTLB_MISSES,
+	NUM_STALL_FIELDS
+};
+const std::string GLOB_stallfields[NUM_STALL_FIELDS] = { "ifq_full ",
+		"ruu_full ", "lsq_full ", "il1.miss_rate ", "dl1.miss_rate ",
+		"ul2.miss_rate ", ".misses", "dtlb.misses " };
+int parsestalls(std::string configuration, int benchmark,
+		double stalls[NUM_STALL_FIELDS]);
+
+/*
+ * loadresults() fills GLOB_extracted_values for a configuration from the
+ * result store, parsing and recording any benchmark the store lacks, and
+ * returns the number of benchmarks without usable results. Configurations
+ * that loaded cleanly are not loaded again.
+ * collectresults() parses one freshly simulated benchmark into the store,
+ * screening runs from under GLOB_outputpath/<instructions>/, and passes on
+ * the simulator's speed as parsesimout() does.
+ * importresults() records every result found under GLOB_outputpath and
+ * summaryfiles/ that the store lacks, parsing on the given number of threads,
+ * and returns how many configurations it completed. simoutpath() is where
+ * runprojectsuite.sh leaves the .simout of a benchmark at a fidelity.
+ */
+int loadresults(std::string configuration);
+int isconfigurationloaded(std::string configuration);
+int collectresults(std::string configuration, int benchmark,
+		unsigned int fidelity = 0, double speed[2] = NULL);
+unsigned int importresults(unsigned int threads);
+std::string simoutpath(std::string configuration, int benchmark,
+		unsigned int fidelity);
+
+/*
+ * Persistent result store: one append-only, memory-mapped file holding the
+ * GLOB_fields values per configuration and benchmark, with an on-disk hash
+ * index keyed by configuration.
+ *
+ * lookupresults() returns the mask of recorded benchmarks (bit i for
+ * GLOB_prefixes[i]) and copies their values if values is not NULL.
+ * recordresults() adds the benchmarks in the mask to a configuration. Both
+ * key on the fidelity level of id as well; storedconfigurations() counts and
+ * storedconfigurationids() lists full-fidelity configurations only.
+ */
+const std::string GLOB_storefile = GLOB_outputpath + "results.store";
+int openresultstore(std::string path);
+void closeresultstore();
+unsigned int storedconfigurations();
+void storedconfigurationids(std::vector<ConfigId>& ids);
+unsigned int lookupresults(ConfigId id, double values[5][7]);
+int recordresults(ConfigId id, unsigned int benchmarks, double values[5][7]);
+
+/*
+ * Trace-driven il1 estimates. loadtraces() reads the traces captured with
+ * "./runprojectsuite.sh <configuration> <benchmark> ptrace", reducing fresh
+ * pipetraces first, and returns the mask of benchmarks with a trace. The
+ * pipetrace carries no data addresses, so only the instruction side is
+ * estimated, and roughly: estimatecaches() fills estimated counters for the
+ * benchmarks whose trace differs from the configuration in il1sets, il1assoc
+ * and il1lat only (mask in benchmarks) and returns how many configurations it
+ * estimated fully. printcacheestimates() prints the estimates for every
+ * configuration one il1 dimension away from center, with measured values
+ * where recorded.
+ */
+unsigned int loadtraces();
+unsigned int estimatecaches(const std::vector<ConfigId>& ids,
+		std::vector<ConfigMetrics>& metrics);
+void printcacheestimates(std::ostream& out, ConfigId center);
+
+/*
+ * Helpers shared by the trace readers. reducepipetraces() reduces every
+ * pipetrace under GLOB_outputpath to its .trace and .btrace and deletes it.
+ * listoutputs() lists the file names under GLOB_outputpath, sorted.
+ * traceconfiguration() parses "<benchmark>.<dotted configuration><suffix>"
+ * and returns 0 unless it names a valid configuration.
+ */
+void reducepipetraces();
+void listoutputs(std::vector<std::string>& names);
+int traceconfiguration(std::string name, std::string suffix, int* benchmark,
+		ConfigId* capture);
+
+/*
+ * Trace-driven branch predictor estimates. A .btrace holds the committed
+ * control transfers of a captured run, each with the PC committed after it.
+ * loadbranchtraces() reads them and returns the mask of benchmarks with one.
+ * estimatebranches() fills estimated counters for the benchmarks whose trace
+ * differs from the configuration in branchsettings, ras and btb only (mask
+ * in benchmarks) and returns how many configurations it estimated fully.
+ * printbranchestimates() prints the bpred_* counters of every branch setting
+ * on center, ranks them on the objective, simulates the best few and prints
+ * the estimates with the measured values where recorded. countbranches()
+ * replays branches through the branch setting of id and appends its counters
+ * with their names as sim-outorder prints them, bpred_<predictor>.<counter>;
+ * lookups counts the committed branches only, where sim-outorder also looks
+ * up wrong-path ones.
+ */
+enum {
+	BRANCH_CONDITIONAL = 1, BRANCH_CALL = 2, BRANCH_RETURN = 4,
+	BRANCH_INDIRECT = 8
+};
+struct BranchRef {
+	uint32_t pc;
+	uint32_t next; // PC committed after it
+	uint32_t kind; // BRANCH_ flags, 0 for a direct jump
+};
+int writebranchtrace(std::string path, const std::vector<BranchRef>& branches);
+unsigned int loadbranchtraces();
+unsigned int estimatebranches(const std::vector<ConfigId>& ids,
+		std::vector<ConfigMetrics>& metrics);
+void printbranchestimates(std::ostream& out, ConfigId center,
+		int optimizeforEDP);
+void countbranches(const std::vector<BranchRef>& branches, ConfigId id,
+		std::vector<std::string>& names, std::vector<double>& counts);
+
 /*
  * return cycle time in seconds, given a configuration string. returns 1ps
  * on error.
  */
+double cycleTime(ConfigId id);
 double cycleTime(std::string configuration);
 
 /*
  * Helper function
  */
-int extractConfigPararm(std::string config, int paramIndex);
+int extractConfigPararm(const std::string& config, int paramIndex);
 
+unsigned int getdl1size(ConfigId id);
+unsigned int getil1size(ConfigId id);
+unsigned int getl2size(ConfigId id);
 unsigned int getdl1size(std::string configuration);
 unsigned int getil1size(std::string configuration);
 unsigned int getl2size(std::string configuration);
\ No newline at end of file
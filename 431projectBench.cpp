@@ -0,0 +1,197 @@
+#ifdef DSE_BENCH
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <new>
+#include <vector>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * Microbenchmarks of the driver's hot paths, built by "make bench".
+ *
+ * The fixtures are the complete configurations under rawProjectOutputData/,
+ * imported into a scratch result store so the real one is left alone. Every
+ * case runs one operation per fixture in turn, doubling the operation count
+ * until a run takes BENCH_SECONDS, and reports time and heap allocations per
+ * operation; the replaced operator new below counts the latter.
+ */
+
+#define BENCH_SECONDS 0.25
+
+static unsigned long benchAllocations = 0;
+
+void* operator new(size_t size) {
+	benchAllocations++;
+	void* block = malloc(size ? size : 1);
+	if (!block) {
+		throw std::bad_alloc();
+	}
+	return block;
+}
+
+void operator delete(void* block) noexcept {
+	free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+	free(block);
+}
+
+static std::vector<ConfigId> fixtureIds;
+static std::vector<std::string> fixtureConfigs;
+static std::string explorerStart;
+static volatile double benchSink; // keeps results from being optimised away
+
+static double benchclock() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void benchpopulatecold(size_t op) {
+	size_t f = op % fixtureIds.size();
+	GLOB_extracted_values[fixtureIds[f]].benchmarks = 0; // forces a reload
+	populate(fixtureConfigs[f]);
+}
+
+static void benchpopulateloaded(size_t op) {
+	populate(fixtureConfigs[op % fixtureConfigs.size()]);
+}
+
+static void benchedp(size_t op) {
+	benchSink = calculateEDP(fixtureIds[op % fixtureIds.size()],
+			op % NUM_BENCHMARKS);
+}
+
+static void benchgeomeanedp(size_t op) {
+	benchSink = calculategeomeanEDP(fixtureIds[op % fixtureIds.size()]);
+}
+
+static void benchgeomeanedpcold(size_t op) {
+	ConfigId id = fixtureIds[op % fixtureIds.size()];
+	invalidatederivedvalues(id);
+	benchSink = calculategeomeanEDP(id);
+}
+
+static void benchgeomeanedpstring(size_t op) {
+	benchSink = calculategeomeanEDP(fixtureConfigs[op % fixtureConfigs.size()]);
+}
+
+static void benchvalidate(size_t op) {
+	benchSink = validateConfiguration(
+			fixtureConfigs[op % fixtureConfigs.size()]);
+}
+
+static void benchnumdim(size_t op) {
+	benchSink = isNumDimConfiguration(
+			fixtureConfigs[op % fixtureConfigs.size()]);
+}
+
+static void benchlatencies(size_t op) {
+	benchSink = generateCacheLatencyParams(
+			fixtureConfigs[op % fixtureConfigs.size()]).size();
+}
+
+/*
+ * One heuristic step from the baseline; the traversal starts over once it
+ * completes, as proposals are not marked seen.
+ */
+static void benchproposal(size_t) {
+	std::string next = generateNextConfigurationProposal(GLOB_baseline,
+			GLOB_baseline, GLOB_baseline, 0, 1);
+	if (GLOB_baseline == next) {
+		restoreExplorerState(explorerStart);
+	}
+	benchSink = next.size();
+}
+
+struct BenchCase {
+	const char* name;
+	void (*run)(size_t op);
+};
+
+static const BenchCase benchCases[] = {
+		{ "populate/cold", benchpopulatecold },
+		{ "populate/loaded", benchpopulateloaded },
+		{ "calculateEDP", benchedp },
+		{ "calculategeomeanEDP/memoized", benchgeomeanedp },
+		{ "calculategeomeanEDP/cold", benchgeomeanedpcold },
+		{ "calculategeomeanEDP/string", benchgeomeanedpstring },
+		{ "validateConfiguration", benchvalidate },
+		{ "isNumDimConfiguration", benchnumdim },
+		{ "generateCacheLatencyParams", benchlatencies },
+		{ "generateNextConfigurationProposal", benchproposal } };
+
+static void runcase(const BenchCase& bench) {
+	unsigned long ops = 1;
+	double seconds;
+	unsigned long allocations;
+	for (;;) {
+		allocations = benchAllocations;
+		double start = benchclock();
+		for (unsigned long op = 0; op < ops; ++op) {
+			bench.run(op);
+		}
+		seconds = benchclock() - start;
+		allocations = benchAllocations - allocations;
+		if (seconds >= BENCH_SECONDS || ops >= (1UL << 32)) {
+			break;
+		}
+		ops *= 2;
+	}
+	printf("%-36s %12lu %12.1f ns/op %10.2f allocs/op\n", bench.name, ops,
+			seconds * 1e9 / ops, (double) allocations / ops);
+}
+
+int runbenchmarks(int argc, char** argv) {
+	char scratch[] = "/tmp/DSEbench.XXXXXX";
+	int fd = mkstemp(scratch);
+	if (fd < 0) {
+		std::cerr << "Cannot create a scratch result store" << std::endl;
+		return -1;
+	}
+	close(fd);
+	if (0 != openresultstore(scratch)) {
+		unlink(scratch);
+		return -1;
+	}
+	importresults(1);
+	std::vector<ConfigId> stored;
+	storedconfigurationids(stored);
+	for (size_t s = 0; s < stored.size(); ++s) {
+		if (0x1f == lookupresults(stored[s], NULL)) {
+			fixtureIds.push_back(stored[s]);
+			fixtureConfigs.push_back(unpackconfiguration(stored[s]));
+			populate(fixtureConfigs.back());
+		}
+	}
+	populate(GLOB_baseline);
+	explorerStart = saveExplorerState();
+	if (fixtureIds.empty()) {
+		std::cerr << "No complete results under " << GLOB_outputpath
+				<< ", nothing to measure" << std::endl;
+		closeresultstore();
+		unlink(scratch);
+		return -1;
+	}
+	printf("%lu fixture configurations\n", (unsigned long) fixtureIds.size());
+
+	for (size_t c = 0; c < sizeof(benchCases) / sizeof(benchCases[0]); ++c) {
+		// an optional argument picks the cases whose name contains it
+		if (argc < 2 || strstr(benchCases[c].name, argv[1])) {
+			runcase(benchCases[c]);
+		}
+	}
+	closeresultstore();
+	unlink(scratch);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,202 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * Bottleneck-directed sweep plans.
+ *
+ * The stall counters of a configuration come from its .simout files, or,
+ * for a benchmark copied from an equivalent configuration, from those of a
+ * member of its simulation class. Each benchmark's cycles are split by
+ * charging every miss event its latency as runprojectsuite.sh sets it:
+ *
+ *   front end   il1 misses x ul2 latency, for the cycles the fetch queue was
+ *               not full anyway
+ *   branch      mispredictions x BOTTLENECK_BRANCH_PENALTY
+ *   L1D         dl1 misses x ul2 latency + dtlb misses x the tlb latency
+ *   L2/memory   ul2 misses x memory latency
+ *   issue       the remaining cycles
+ *
+ * An out-of-order core overlaps misses, so the charges can exceed the cycles;
+ * they are then scaled down to fill them and issue gets none. The shares are
+ * averaged over the benchmarks.
+ *
+ * At the start of each traversal the heuristic sweeps the dimensions of the
+ * categories of its current best by falling share. A category below
+ * BOTTLENECK_NEGLIGIBLE is left out, unless EDP is the objective and its
+ * dimensions change the energy model's cache sizes or core, where shrinking
+ * them pays even if they are no bottleneck; only branch dimensions have no
+ * energy cost. Issue is never left out: it is what remains, and the scaling
+ * leaves nothing whenever misses overlap heavily.
+ */
+
+#define BOTTLENECK_BRANCH_PENALTY 8.0 // cycles per misprediction
+#define BOTTLENECK_TLB_LATENCY 30.0 // -tlb:lat
+
+struct StallCounters {
+	double values[NUM_BENCHMARKS][NUM_STALL_FIELDS];
+	unsigned int benchmarks; // bit i: values[i] were read
+};
+
+static const char* bottleneckNames[NUM_BOTTLENECKS] = { "front end", "branch",
+		"L1D", "L2/memory", "issue" };
+
+// Dimensions that address each category, -1 padded; the first to claim a
+// shared dimension sweeps it.
+static const int bottleneckDims[NUM_BOTTLENECKS][4] = {
+		{ 5, 6, 2, -1 }, // il1sets, il1assoc, l1block
+		{ 12, 13, 14, -1 }, // branchsettings, ras, btb
+		{ 3, 4, 2, 10 }, // dl1sets, dl1assoc, l1block, replacepolicy
+		{ 7, 9, 8, 10 }, // ul2sets, ul2assoc, ul2block, replacepolicy
+		{ 0, 1, 11, -1 } }; // width, scheduling, fpwidth
+// Categories that may be left out when negligible, for time and for EDP.
+static const int bottleneckOptional[2][NUM_BOTTLENECKS] = { { 1, 1, 1, 1, 0 },
+		{ 0, 1, 0, 0, 0 } };
+
+static ConfigTable<StallCounters> stallTable;
+static int bottleneckEDP = 1;
+static unsigned int plannedTraversals = 0;
+static unsigned int skippedPoints = 0;
+
+void preparebottlenecks(int optimizeforEDP) {
+	bottleneckEDP = !!optimizeforEDP;
+}
+
+/*
+ * Stall counters of a configuration, read once.
+ */
+static const StallCounters& loadstalls(ConfigId id) {
+	StallCounters* found = stallTable.find(id);
+	if (found) {
+		return *found;
+	}
+	StallCounters counters;
+	counters.benchmarks = 0;
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		std::vector<ConfigId> members(1, id);
+		equivalentconfigurations(id, i, members);
+		for (size_t m = 0; m < members.size(); ++m) {
+			if (parsestalls(unpackconfiguration(members[m]), i,
+					counters.values[i])) {
+				counters.benchmarks |= 1 << i;
+				break;
+			}
+		}
+	}
+	StallCounters& stored = stallTable[id];
+	stored = counters;
+	return stored;
+}
+
+unsigned int bottleneckshares(ConfigId id, double shares[NUM_BOTTLENECKS]) {
+	std::string configuration = unpackconfiguration(id);
+	if (!isconfigurationloaded(configuration)) {
+		loadresults(configuration);
+	}
+	const ConfigMetrics& metrics = *GLOB_extracted_values.find(id);
+	const StallCounters& counters = loadstalls(id);
+	double ul2latency = 5 + configparam(id, 17);
+	double memorylatency = 51 + 7 * ((16 << configparam(id, 8)) / 8 - 1);
+	std::fill(shares, shares + NUM_BOTTLENECKS, 0.0);
+	unsigned int used = 0;
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		const double* stalls = counters.values[i];
+		const double* values = metrics.values[i];
+		if (!(counters.benchmarks & metrics.benchmarks & (1 << i))
+				|| !(values[FIELD_SIM_CYCLE] > 0)) {
+			continue;
+		}
+		double charged[NUM_BOTTLENECKS];
+		charged[BOTTLENECK_FRONTEND] = stalls[STALL_IL1_MISS_RATE]
+				* values[FIELD_IL1_ACCESSES] * ul2latency
+				* (1 - stalls[STALL_IFQ_FULL]);
+		charged[BOTTLENECK_BRANCH] = stalls[STALL_BPRED_MISSES]
+				* BOTTLENECK_BRANCH_PENALTY;
+		charged[BOTTLENECK_L1D] = stalls[STALL_DL1_MISS_RATE]
+				* values[FIELD_DL1_ACCESSES] * ul2latency
+				+ stalls[STALL_DTLB_MISSES] * BOTTLENECK_TLB_LATENCY;
+		charged[BOTTLENECK_MEMORY] = values[FIELD_UL2_MISSES] * memorylatency;
+		double total = 0;
+		for (int b = 0; b < BOTTLENECK_ISSUE; ++b) {
+			total += charged[b];
+		}
+		double cycles = values[FIELD_SIM_CYCLE];
+		double scale = (total > cycles) ? cycles / total : 1.0;
+		for (int b = 0; b < BOTTLENECK_ISSUE; ++b) {
+			shares[b] += charged[b] * scale / cycles;
+		}
+		shares[BOTTLENECK_ISSUE] += 1 - total * scale / cycles;
+		used |= 1 << i;
+	}
+	int count = __builtin_popcount(used);
+	for (int b = 0; count && b < NUM_BOTTLENECKS; ++b) {
+		shares[b] /= count;
+	}
+	return used;
+}
+
+int bottleneckplan(ConfigId best, std::vector<SweepStep>& plan) {
+	double shares[NUM_BOTTLENECKS];
+	if (!bottleneckshares(best, shares)) {
+		std::cout << "No stall counters for " << unpackconfiguration(best)
+				<< ", sweep plan unchanged" << std::endl;
+		return 0;
+	}
+	std::vector<std::pair<double, int> > order;
+	for (int b = 0; b < NUM_BOTTLENECKS; ++b) {
+		order.push_back(std::make_pair(-shares[b], b));
+	}
+	std::stable_sort(order.begin(), order.end());
+
+	int planned[NUM_DIMS] = { 0 };
+	plan.clear();
+	for (size_t o = 0; o < order.size(); ++o) {
+		int b = order[o].second;
+		if (shares[b] < BOTTLENECK_NEGLIGIBLE
+				&& bottleneckOptional[bottleneckEDP][b]) {
+			continue;
+		}
+		for (int k = 0; k < 4 && bottleneckDims[b][k] >= 0; ++k) {
+			int dim = bottleneckDims[b][k];
+			if (!planned[dim]++) {
+				SweepStep step = { dim, -1 };
+				plan.push_back(step);
+			}
+		}
+	}
+
+	char share[32];
+	std::cout << "Bottlenecks of " << unpackconfiguration(best) << ":";
+	for (size_t o = 0; o < order.size(); ++o) {
+		snprintf(share, sizeof(share), " %.1f%%", 100 * shares[order[o].second]);
+		std::cout << (o ? "," : "") << " " << bottleneckNames[order[o].second]
+				<< share;
+	}
+	std::cout << std::endl << "Sweep plan:";
+	for (size_t s = 0; s < plan.size(); ++s) {
+		std::cout << (s ? ", " : " ") << GLOB_dimensionnames[plan[s].dim];
+	}
+	std::cout << std::endl << "Skipped:";
+	int skipped = 0;
+	for (int dim = 0; dim < NUM_DIMS - NUM_DIMS_DEPENDENT; ++dim) {
+		if (!planned[dim]) {
+			std::cout << (skipped++ ? ", " : " ") << GLOB_dimensionnames[dim];
+			skippedPoints += GLOB_dimensioncardinality[dim] - 1;
+		}
+	}
+	std::cout << std::endl << std::endl;
+	plannedTraversals++;
+	return 1;
+}
+
+void printbottlenecksavings(std::ostream& out) {
+	out << "Bottleneck planning left " << skippedPoints
+			<< " sweep points out over " << plannedTraversals << " traversals"
+			<< std::endl;
+}
@@ -0,0 +1,180 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <math.h>
+
+#include "431project.h"
+
+/*
+ * Branch and bound across the benchmarks of a configuration.
+ *
+ * The model's time and EDP only grow with every counter, and a benchmark
+ * commits at most width instructions a cycle, so the model evaluated at that
+ * many cycles and no cache traffic bounds a benchmark not yet simulated.
+ * Pruning on that bound never drops a configuration that would have been the
+ * best. With ratio pruning on, and once BOUND_HISTORY configurations are
+ * complete, benchmark j is also estimated at BOUND_SLACK times the smallest
+ * ratio of j to i recorded on any configuration, times what benchmark i cost
+ * on this one. That is a heuristic, not a bound: nothing keeps a
+ * configuration not yet seen from a smaller ratio, so it may prune the one
+ * that would have been the best. Benchmarks whose metric spreads the most
+ * over the recorded configurations go first, as they are the likeliest to
+ * settle the bound early.
+ */
+
+#define BOUND_SLACK 0.9
+#define BOUND_HISTORY 20 // complete configurations before ratios are trusted
+
+static double minimumRatio[NUM_BENCHMARKS][NUM_BENCHMARKS]; // [j][i]: j / i
+static unsigned int ratioSamples = 0;
+static int ratioPruning = 0;
+static int benchmarkOrder[NUM_BENCHMARKS] = { 0, 1, 2, 3, 4 };
+
+/*
+ * Lowers the benchmark ratios to those of one complete configuration.
+ */
+static void updateratios(const double metric[NUM_BENCHMARKS]) {
+	for (int j = 0; j < NUM_BENCHMARKS; ++j) {
+		for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+			double ratio = metric[j] / metric[i];
+			if (0 == ratioSamples || ratio < minimumRatio[j][i]) {
+				minimumRatio[j][i] = ratio;
+			}
+		}
+	}
+	ratioSamples++;
+}
+
+struct SpreadOrder {
+	const double* spread;
+	bool operator()(int a, int b) const {
+		return spread[a] > spread[b];
+	}
+};
+
+void preparebounds(int optimizeforEDP, int ratios) {
+	ratioPruning = ratios;
+	EvaluationBatch batch;
+	evaluatehistory(batch);
+	const std::vector<double>* metric = optimizeforEDP ? batch.edp : batch.time;
+	ratioSamples = 0;
+	for (size_t n = 0; n < batch.ids.size(); ++n) {
+		double values[NUM_BENCHMARKS];
+		for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+			values[i] = metric[i][n];
+		}
+		updateratios(values);
+	}
+	double spread[NUM_BENCHMARKS];
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		double sum = 0, squares = 0;
+		for (size_t n = 0; n < batch.ids.size(); ++n) {
+			sum += log(metric[i][n]);
+			squares += log(metric[i][n]) * log(metric[i][n]);
+		}
+		double count = batch.ids.size();
+		spread[i] = (count > 1) ? squares / count - (sum / count) * (sum / count)
+				: 0;
+		benchmarkOrder[i] = i;
+	}
+	SpreadOrder order;
+	order.spread = spread;
+	std::stable_sort(benchmarkOrder, benchmarkOrder + NUM_BENCHMARKS, order);
+	setbenchmarkorder(benchmarkOrder);
+}
+
+/*
+ * Time or EDP of every benchmark of a configuration: measured for those in
+ * the mask, the width bound for the others.
+ */
+static void benchmarkmetrics(ConfigId id, unsigned int benchmarks,
+		const double values[5][7], int optimizeforEDP,
+		double metric[NUM_BENCHMARKS]) {
+	ConfigMetrics metrics;
+	double insn = GLOB_fidelityinsts[0];
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		if (benchmarks & (1 << i)) {
+			std::copy(values[i], values[i] + NUM_FIELDS, metrics.values[i]);
+		} else {
+			std::fill(metrics.values[i], metrics.values[i] + NUM_FIELDS, 0.0);
+			metrics.values[i][FIELD_SIM_NUM_INSN] = insn;
+			metrics.values[i][FIELD_SIM_CYCLE] = insn / (1 << configparam(id, 0));
+		}
+	}
+	metrics.benchmarks = 0x1f;
+	EvaluationBatch batch;
+	batch.add(id, metrics);
+	evaluatebatch(batch, 0);
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		metric[i] = optimizeforEDP ? batch.edp[i][0] : batch.time[i][0];
+	}
+}
+
+double geomeanbound(ConfigId id, unsigned int benchmarks,
+		const double values[5][7], int optimizeforEDP) {
+	double metric[NUM_BENCHMARKS];
+	benchmarkmetrics(id, benchmarks, values, optimizeforEDP, metric);
+	double product = 1.0;
+	for (int j = 0; j < NUM_BENCHMARKS; ++j) {
+		double bound = metric[j];
+		for (int i = 0; !(benchmarks & (1 << j)) && i < NUM_BENCHMARKS; ++i) {
+			if ((benchmarks & (1 << i)) && ratioPruning
+					&& ratioSamples >= BOUND_HISTORY) {
+				bound = std::max(bound,
+						BOUND_SLACK * minimumRatio[j][i] * metric[i]);
+			}
+		}
+		product *= bound;
+	}
+	return pow(product, 1.0 / NUM_BENCHMARKS);
+}
+
+int runbounded(std::string configuration, unsigned int iteration, double best,
+		int optimizeforEDP, double* bound) {
+	std::cout << "Iter # " << iteration << " config: " << configuration;
+
+	if (!isNumDimConfiguration(configuration)) { // as runexperiments() does
+		std::cerr << "ATTEMPTING TO RUN INCORRECTLY FORMATTED CONFIGURATION!\n"
+				"ABORTING EXECUTION IMMEDIATELY!\n"
+				"Configuration in question: " << configuration << std::endl;
+		exit(-1);
+	}
+	ConfigId id = packconfiguration(configuration);
+	double values[5][7];
+	unsigned int recorded = lookupresults(id, values);
+	*bound = geomeanbound(id, recorded, values, optimizeforEDP);
+	if (0x1f == recorded) {
+		std::cout << " : found in file"; // *bound is the stored geomean
+		return 0;
+	}
+	// What an interrupted run left, or the width alone, may settle it already.
+	if (*bound > best) {
+		return RUN_PRUNED;
+	}
+	submitexperiments(configuration);
+	std::cout << " : running simulation";
+	// Submitting may already copy results from equivalent configurations.
+	do {
+		unsigned int now = lookupresults(id, values);
+		if (now == recorded) {
+			continue;
+		}
+		recorded = now;
+		*bound = geomeanbound(id, recorded, values, optimizeforEDP);
+		if (*bound > best) {
+			cancelexperiments(configuration);
+			return RUN_PRUNED;
+		}
+	} while (stepexperiments(configuration));
+	if (0x1f == recorded) {
+		double metric[NUM_BENCHMARKS];
+		benchmarkmetrics(id, recorded, values, optimizeforEDP, metric);
+		updateratios(metric);
+	}
+	return NUM_BENCHMARKS - __builtin_popcount(recorded);
+}
@@ -0,0 +1,619 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include <math.h>
+
+#include "431project.h"
+
+/*
+ * Trace-driven branch predictor estimates.
+ *
+ * The committed control transfers of a captured run (see
+ * 431projectTrace.cpp) are replayed in one pass through every predictor
+ * runprojectsuite.sh configures, with every RAS size and BTB geometry, the
+ * way sim-outorder's bpred.c looks them up and updates them:
+ *
+ * - Conditional branches take the direction of a 2-bit counter: bimod
+ *   indexes its 2048 by address, 2lev by the branch history of its level 1
+ *   entry followed by address bits, and comb picks bimod or 2lev 1/1024/8 by
+ *   a 1024 entry meta table trained where the two disagree.
+ * - Returns pop the return address stack, calls push it.
+ * - Other taken transfers take their target from the BTB, which allocates
+ *   taken branches only, LRU within a set.
+ * - nottaken keeps no state and predicts the fall-through of every control
+ *   transfer, returns and jumps included, so only branches not taken hit and
+ *   it never uses the RAS, as bpred_lookup() returns before consulting it.
+ *
+ * The tables of comb's components follow the same updates as the bimod and
+ * 2lev 1/1024/8 predictors, so one copy of each serves both, and the BTB
+ * contents do not depend on the predictor, so one copy per geometry serves
+ * all but nottaken. A pass over n branches thus costs a few table updates per
+ * branch plus the 100 counter sets.
+ *
+ * Predictions are made and resolved in commit order, where sim-outorder looks
+ * up at fetch and trains at commit. Estimates are differences from the
+ * measured run the trace came from: sim_cycle moves by a misprediction
+ * penalty and il1.accesses by wrong-path fetches per misprediction, both
+ * fitted to recorded runs that differ in the branch dimensions only when
+ * there are enough of them.
+ */
+
+#define BTRACE_VERSION 1
+#define BRANCH_CALIBRATION_MIN 4 // recorded runs needed to fit the penalties
+#define BRANCH_PENALTY 8.0 // default cycles per misprediction
+#define BRANCH_VERIFIED 3 // distinct best estimates given a full run by -branches
+#define INSN_SIZE 8 // PISA instructions, sizeof(md_inst_t)
+#define BR_SHIFT 3 // MD_BR_SHIFT
+
+enum {
+	PRED_NOTTAKEN = 0, PRED_BIMOD, PRED_2LEV1, PRED_2LEV4, PRED_COMB,
+	NUM_PREDICTORS
+};
+#define NUM_RAS 4
+#define NUM_BTB 5
+
+static const unsigned int rasSizes[NUM_RAS] = { 1, 2, 4, 8 };
+static const unsigned int btbSets[NUM_BTB] = { 128, 256, 512, 1024, 2048 };
+static const unsigned int btbAssoc[NUM_BTB] = { 16, 8, 4, 2, 1 };
+
+static const char branchMagic[8] = { 'D', 'S', 'E', 'B', 'R', 'N', 'C', 'H' };
+
+/*
+ * sim-outorder's bpred_<predictor>.* statistics over the committed branches.
+ */
+enum {
+	BPRED_LOOKUPS = 0,
+	BPRED_ADDR_HITS,
+	BPRED_DIR_HITS,
+	BPRED_MISSES,
+	BPRED_USED_RAS,
+	BPRED_RAS_HITS,
+	BPRED_JR_SEEN,
+	BPRED_JR_HITS,
+	NUM_BPRED_COUNTERS
+};
+static const char* bpredNames[NUM_BPRED_COUNTERS] = { "lookups", "addr_hits",
+		"dir_hits", "misses", "used_ras.PP", "ras_hits.PP", "jr_seen",
+		"jr_hits" };
+static const char* predictorNames[NUM_PREDICTORS] = { "nottaken", "bimod",
+		"2lev", "2lev", "comb" };
+
+struct BranchCounters {
+	uint64_t count[NUM_PREDICTORS][NUM_RAS][NUM_BTB][NUM_BPRED_COUNTERS];
+};
+
+struct BranchTrace {
+	ConfigId capture; // configuration the trace was recorded on
+	std::vector<BranchRef> branches;
+	BranchCounters counters;
+	double penalty; // sim_cycle per misprediction
+	double refetch; // il1.accesses per misprediction
+	int calibrated;
+};
+
+static BranchTrace branchTraces[NUM_BENCHMARKS];
+static unsigned int branchMask = 0;
+
+int writebranchtrace(std::string path, const std::vector<BranchRef>& branches) {
+	FILE* trace = fopen(path.c_str(), "wb");
+	if (!trace) {
+		return -1;
+	}
+	uint32_t version = BTRACE_VERSION;
+	uint64_t count = branches.size();
+	int ok = 1 == fwrite(branchMagic, sizeof(branchMagic), 1, trace)
+			&& 1 == fwrite(&version, sizeof(version), 1, trace)
+			&& 1 == fwrite(&count, sizeof(count), 1, trace)
+			&& (0 == count
+					|| count
+							== fwrite(&branches[0], sizeof(BranchRef), count,
+									trace));
+	return (0 == fclose(trace) && ok) ? 0 : -1;
+}
+
+static int readbranchtrace(std::string path, std::vector<BranchRef>& branches) {
+	FILE* trace = fopen(path.c_str(), "rb");
+	if (!trace) {
+		return -1;
+	}
+	char magic[8];
+	uint32_t version;
+	uint64_t count;
+	int ok = 1 == fread(magic, sizeof(magic), 1, trace)
+			&& 0 == memcmp(magic, branchMagic, sizeof(magic))
+			&& 1 == fread(&version, sizeof(version), 1, trace)
+			&& BTRACE_VERSION == version
+			&& 1 == fread(&count, sizeof(count), 1, trace);
+	if (ok) {
+		branches.resize(count);
+		ok = 0 == count
+				|| count
+						== fread(&branches[0], sizeof(BranchRef), count, trace);
+	}
+	fclose(trace);
+	return ok ? 0 : -1;
+}
+
+/*
+ * 2-bit counters start weakly not taken and weakly taken in turn, as
+ * bpred_dir_create() sets them.
+ */
+static void initcounters(std::vector<uint8_t>& table, unsigned int size) {
+	table.resize(size);
+	for (unsigned int n = 0; n < size; ++n) {
+		table[n] = 1 + (n & 1);
+	}
+}
+
+static inline unsigned int bimodindex(uint32_t pc, unsigned int size) {
+	return ((pc >> 19) ^ (pc >> BR_SHIFT)) & (size - 1);
+}
+
+static inline void train(uint8_t& counter, int taken) {
+	if (taken) {
+		counter += counter < 3;
+	} else {
+		counter -= counter > 0;
+	}
+}
+
+struct TwoLevel {
+	unsigned int history; // shift register width
+	std::vector<uint32_t> shiftregs; // level 1
+	std::vector<uint8_t> table; // level 2
+};
+
+static void inittwolevel(TwoLevel& predictor, unsigned int l1size,
+		unsigned int l2size, unsigned int history) {
+	predictor.history = history;
+	predictor.shiftregs.assign(l1size, 0);
+	initcounters(predictor.table, l2size);
+}
+
+static inline uint32_t& shiftregister(TwoLevel& predictor, uint32_t pc) {
+	return predictor.shiftregs[(pc >> BR_SHIFT)
+			& (predictor.shiftregs.size() - 1)];
+}
+
+static inline uint8_t& twolevelcounter(TwoLevel& predictor, uint32_t pc) {
+	return predictor.table[(shiftregister(predictor, pc)
+			| ((pc >> BR_SHIFT) << predictor.history))
+			& (predictor.table.size() - 1)];
+}
+
+/*
+ * A BTB of one geometry, each set most recently updated first.
+ */
+struct BranchTargets {
+	unsigned int sets;
+	unsigned int assoc;
+	std::vector<uint32_t> address;
+	std::vector<uint32_t> target;
+};
+
+static void inittargets(BranchTargets& btb, unsigned int sets,
+		unsigned int assoc) {
+	btb.sets = sets;
+	btb.assoc = assoc;
+	btb.address.assign(sets * assoc, 0);
+	btb.target.assign(sets * assoc, 0);
+}
+
+static inline unsigned int btbset(const BranchTargets& btb, uint32_t pc) {
+	return ((pc >> BR_SHIFT) & (btb.sets - 1)) * btb.assoc;
+}
+
+static inline int btblookup(const BranchTargets& btb, uint32_t pc,
+		uint32_t* target) {
+	unsigned int set = btbset(btb, pc);
+	for (unsigned int way = 0; way < btb.assoc; ++way) {
+		if (btb.address[set + way] == pc) {
+			*target = btb.target[set + way];
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static inline void btbupdate(BranchTargets& btb, uint32_t pc, uint32_t target) {
+	unsigned int set = btbset(btb, pc);
+	unsigned int way = 0;
+	while (way < btb.assoc - 1 && btb.address[set + way] != pc) {
+		++way; // a miss ends on the least recently updated way
+	}
+	memmove(&btb.address[set + 1], &btb.address[set], way * sizeof(uint32_t));
+	memmove(&btb.target[set + 1], &btb.target[set], way * sizeof(uint32_t));
+	btb.address[set] = pc;
+	btb.target[set] = target;
+}
+
+struct ReturnStack {
+	unsigned int tos;
+	std::vector<uint32_t> stack;
+};
+
+/*
+ * Replays the branches of a trace through every predictor, RAS size and BTB
+ * geometry at once.
+ */
+static void simulatebranches(const std::vector<BranchRef>& branches,
+		BranchCounters& counters) {
+	memset(&counters, 0, sizeof(counters));
+	std::vector<uint8_t> bimod, meta;
+	initcounters(bimod, 2048);
+	initcounters(meta, 1024);
+	TwoLevel twolevel[2];
+	inittwolevel(twolevel[0], 1, 1024, 8);
+	inittwolevel(twolevel[1], 4, 256, 8);
+	ReturnStack ras[NUM_RAS];
+	for (int r = 0; r < NUM_RAS; ++r) {
+		ras[r].tos = rasSizes[r] - 1;
+		ras[r].stack.assign(rasSizes[r], 0);
+	}
+	BranchTargets btb[NUM_BTB];
+	for (int b = 0; b < NUM_BTB; ++b) {
+		inittargets(btb[b], btbSets[b], btbAssoc[b]);
+	}
+
+	for (size_t n = 0; n < branches.size(); ++n) {
+		const BranchRef& branch = branches[n];
+		uint32_t pc = branch.pc;
+		uint32_t fallthrough = pc + INSN_SIZE;
+		int conditional = branch.kind & BRANCH_CONDITIONAL;
+		int returns = !conditional && (branch.kind & BRANCH_RETURN);
+		int taken = branch.next != fallthrough;
+
+		// Lookups, before any state changes.
+		int predicttaken[NUM_PREDICTORS] = { 0, 0, 0, 0, 0 };
+		uint8_t* bimodcounter = NULL;
+		uint8_t* twolevelcounters[2] = { NULL, NULL };
+		uint8_t* metacounter = NULL;
+		if (conditional) {
+			bimodcounter = &bimod[bimodindex(pc, bimod.size())];
+			twolevelcounters[0] = &twolevelcounter(twolevel[0], pc);
+			twolevelcounters[1] = &twolevelcounter(twolevel[1], pc);
+			metacounter = &meta[bimodindex(pc, meta.size())];
+			predicttaken[PRED_BIMOD] = *bimodcounter >= 2;
+			predicttaken[PRED_2LEV1] = *twolevelcounters[0] >= 2;
+			predicttaken[PRED_2LEV4] = *twolevelcounters[1] >= 2;
+			predicttaken[PRED_COMB] =
+					*metacounter >= 2 ?
+							predicttaken[PRED_2LEV1] : predicttaken[PRED_BIMOD];
+		}
+		uint32_t returnaddress[NUM_RAS];
+		for (int r = 0; r < NUM_RAS; ++r) {
+			ReturnStack& stack = ras[r];
+			if (returns) {
+				returnaddress[r] = stack.stack[stack.tos];
+				stack.tos = (stack.tos + rasSizes[r] - 1) % rasSizes[r];
+			} else if (branch.kind & BRANCH_CALL) {
+				stack.tos = (stack.tos + 1) % rasSizes[r];
+				stack.stack[stack.tos] = fallthrough;
+			}
+		}
+		uint32_t btbtarget[NUM_BTB];
+		int btbhit[NUM_BTB];
+		for (int b = 0; b < NUM_BTB; ++b) {
+			btbhit[b] = btblookup(btb[b], pc, &btbtarget[b]);
+		}
+
+		for (int p = 0; p < NUM_PREDICTORS; ++p) {
+			for (int r = 0; r < NUM_RAS; ++r) {
+				for (int b = 0; b < NUM_BTB; ++b) {
+					// 1 stands for taken without a target, as in bpred.c
+					uint32_t predicted;
+					if (PRED_NOTTAKEN == p
+							|| (conditional && !predicttaken[p])) {
+						predicted = fallthrough;
+					} else if (returns) {
+						predicted = returnaddress[r];
+					} else if (btbhit[b]) {
+						predicted = btbtarget[b];
+					} else {
+						predicted = 1;
+					}
+					int correct = predicted == branch.next;
+					uint64_t* count = counters.count[p][r][b];
+					count[BPRED_LOOKUPS]++;
+					count[BPRED_ADDR_HITS] += correct;
+					if ((predicted != fallthrough) == taken) {
+						count[BPRED_DIR_HITS]++;
+					} else {
+						count[BPRED_MISSES]++;
+					}
+					if (returns && PRED_NOTTAKEN != p) {
+						count[BPRED_USED_RAS]++;
+						count[BPRED_RAS_HITS] += correct;
+					}
+					if (branch.kind & BRANCH_INDIRECT) {
+						count[BPRED_JR_SEEN]++;
+						count[BPRED_JR_HITS] += correct;
+					}
+				}
+			}
+		}
+
+		// Updates. Returns predicted by the RAS leave everything else be.
+		if (conditional) {
+			for (int t = 0; t < 2; ++t) {
+				uint32_t& history = shiftregister(twolevel[t], pc);
+				history = ((history << 1) | taken)
+						& ((1u << twolevel[t].history) - 1);
+				train(*twolevelcounters[t], taken);
+			}
+			train(*bimodcounter, taken);
+			if (predicttaken[PRED_BIMOD] != predicttaken[PRED_2LEV1]) {
+				train(*metacounter, predicttaken[PRED_2LEV1] == taken);
+			}
+		}
+		if (taken && !returns) {
+			for (int b = 0; b < NUM_BTB; ++b) {
+				btbupdate(btb[b], pc, branch.next);
+			}
+		}
+	}
+}
+
+void countbranches(const std::vector<BranchRef>& branches, ConfigId id,
+		std::vector<std::string>& names, std::vector<double>& counts) {
+	BranchCounters* replayed = new BranchCounters;
+	simulatebranches(branches, *replayed);
+	int p = configparam(id, 12);
+	const uint64_t* count = replayed->count[p][configparam(id, 13)][configparam(
+			id, 14)];
+	for (int k = 0; k < NUM_BPRED_COUNTERS; ++k) {
+		names.push_back(
+				std::string("bpred_") + predictorNames[p] + "." + bpredNames[k]);
+		counts.push_back(count[k]);
+	}
+	delete replayed;
+}
+
+static inline double mispredictions(const BranchCounters& counters,
+		ConfigId id) {
+	const uint64_t* count = counters.count[configparam(id, 12)][configparam(id,
+			13)][configparam(id, 14)];
+	return (double) count[BPRED_LOOKUPS] - count[BPRED_ADDR_HITS];
+}
+
+static int isbranchtraceable(const BranchTrace& trace, ConfigId id) {
+	ConfigId mask = 0;
+	for (int dim = 12; dim <= 14; ++dim) {
+		mask = setconfigparam(mask, dim, (1u << GLOB_dimensionbits[dim]) - 1);
+	}
+	return (id & ~mask) == (trace.capture & ~mask);
+}
+
+/*
+ * Misprediction penalty and wrong-path fetches until the fit: the fetch
+ * redirect latency plus the pipeline refilled, at full fetch width.
+ */
+static double defaultrefetch(ConfigId id) {
+	return BRANCH_PENALTY * (1 << configparam(id, 0)) / 2;
+}
+
+/*
+ * Fits the penalties of a benchmark to recorded runs that differ from the
+ * traced configuration in the branch dimensions only, by least squares
+ * pulled towards the defaults.
+ */
+static void calibratebranches(BranchTrace& trace, int benchmark,
+		const double reference[NUM_FIELDS]) {
+	trace.penalty = BRANCH_PENALTY;
+	trace.refetch = defaultrefetch(trace.capture);
+	trace.calibrated = 0;
+	std::vector<ConfigId> stored;
+	storedconfigurationids(stored);
+	double xx = 0, xcycles = 0, xfetches = 0;
+	unsigned int runs = 0;
+	double base = mispredictions(trace.counters, trace.capture);
+	for (size_t n = 0; n < stored.size(); ++n) {
+		double values[5][7];
+		if (stored[n] == trace.capture || !isbranchtraceable(trace, stored[n])
+				|| !(lookupresults(stored[n], values) & (1 << benchmark))) {
+			continue;
+		}
+		double x = mispredictions(trace.counters, stored[n]) - base;
+		xx += x * x;
+		xcycles += x
+				* (values[benchmark][FIELD_SIM_CYCLE]
+						- reference[FIELD_SIM_CYCLE]);
+		xfetches += x
+				* (values[benchmark][FIELD_IL1_ACCESSES]
+						- reference[FIELD_IL1_ACCESSES]);
+		runs++;
+	}
+	if (runs < BRANCH_CALIBRATION_MIN) {
+		return;
+	}
+	double mu = 1e-3 * xx + 1e-9;
+	trace.penalty = (xcycles + mu * trace.penalty) / (xx + mu);
+	trace.refetch = (xfetches + mu * trace.refetch) / (xx + mu);
+	trace.calibrated = runs;
+}
+
+unsigned int loadbranchtraces() {
+	reducepipetraces();
+	std::vector<std::string> names;
+	listoutputs(names);
+	for (size_t n = 0; n < names.size(); ++n) {
+		int benchmark;
+		ConfigId capture;
+		if (!traceconfiguration(names[n], ".btrace", &benchmark, &capture)
+				|| (branchMask & (1 << benchmark))) {
+			continue;
+		}
+		BranchTrace& trace = branchTraces[benchmark];
+		if (0 != readbranchtrace(GLOB_outputpath + names[n], trace.branches)) {
+			std::cerr << "cannot read branch trace " << names[n] << std::endl;
+			continue;
+		}
+		double reference[5][7];
+		if (!(lookupresults(capture, reference) & (1 << benchmark))) {
+			std::cerr << "branch trace " << names[n]
+					<< " has no recorded run to start from" << std::endl;
+			trace.branches.clear();
+			continue;
+		}
+		trace.capture = capture;
+		simulatebranches(trace.branches, trace.counters);
+		calibratebranches(trace, benchmark, reference[benchmark]);
+		branchMask |= 1 << benchmark;
+	}
+	return branchMask;
+}
+
+unsigned int estimatebranches(const std::vector<ConfigId>& ids,
+		std::vector<ConfigMetrics>& metrics) {
+	metrics.assign(ids.size(), ConfigMetrics());
+	unsigned int estimated = 0;
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		if (!(branchMask & (1 << i))) {
+			continue;
+		}
+		const BranchTrace& trace = branchTraces[i];
+		double reference[5][7];
+		lookupresults(trace.capture, reference);
+		const double* measured = reference[i];
+		double base = mispredictions(trace.counters, trace.capture);
+		for (size_t n = 0; n < ids.size(); ++n) {
+			if (!isvalidconfiguration(ids[n])
+					|| !isbranchtraceable(trace, ids[n])) {
+				continue;
+			}
+			double change = mispredictions(trace.counters, ids[n]) - base;
+			double* values = metrics[n].values[i];
+			std::copy(measured, measured + NUM_FIELDS, values);
+			values[FIELD_SIM_CYCLE] = std::max(
+					measured[FIELD_SIM_CYCLE] + trace.penalty * change,
+					measured[FIELD_SIM_NUM_INSN] / 8); // width 8 at best
+			values[FIELD_IL1_ACCESSES] = std::max(
+					measured[FIELD_IL1_ACCESSES] + trace.refetch * change,
+					measured[FIELD_SIM_NUM_INSN]);
+			metrics[n].benchmarks |= 1 << i;
+		}
+	}
+	for (size_t n = 0; n < ids.size(); ++n) {
+		estimated += (0x1f == metrics[n].benchmarks);
+	}
+	return estimated;
+}
+
+void printbranchestimates(std::ostream& out, ConfigId center,
+		int optimizeforEDP) {
+	unsigned int usable = 0;
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		if ((branchMask & (1 << i))
+				&& isbranchtraceable(branchTraces[i], center)) {
+			usable |= 1 << i;
+		} else {
+			out << "no branch trace for benchmark " << i << "; capture one with"
+					<< " ./runprojectsuite.sh " << unpackconfiguration(center)
+					<< " " << i << " ptrace" << std::endl;
+		}
+	}
+	if (0x1f != usable) {
+		return;
+	}
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		out << "benchmark " << i << ": " << branchTraces[i].branches.size()
+				<< " branches, " << branchTraces[i].penalty
+				<< " cycles and " << branchTraces[i].refetch
+				<< " fetches per misprediction";
+		if (branchTraces[i].calibrated) {
+			out << " (fitted to " << branchTraces[i].calibrated
+					<< " recorded runs)";
+		} else {
+			out << " (defaults)";
+		}
+		out << std::endl;
+	}
+
+	// The bpred_* counters of every setting, as sim-outorder names them.
+	out << "benchmark,branchsettings,ras,btb";
+	for (int k = 0; k < NUM_BPRED_COUNTERS; ++k) {
+		out << "," << bpredNames[k];
+	}
+	out << std::endl;
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		for (int p = 0; p < NUM_PREDICTORS; ++p) {
+			for (int r = 0; r < NUM_RAS; ++r) {
+				for (int b = 0; b < NUM_BTB; ++b) {
+					out << i << "," << p << "," << r << "," << b;
+					for (int k = 0; k < NUM_BPRED_COUNTERS; ++k) {
+						out << ","
+								<< branchTraces[i].counters.count[p][r][b][k];
+					}
+					out << std::endl;
+				}
+			}
+		}
+	}
+
+	// Rank the settings on center, then simulate the best few.
+	std::vector<ConfigId> ids;
+	for (int p = 0; p < NUM_PREDICTORS; ++p) {
+		for (int r = 0; r < NUM_RAS; ++r) {
+			for (int b = 0; b < NUM_BTB; ++b) {
+				ids.push_back(setconfigparam(setconfigparam(setconfigparam(
+						center, 12, p), 13, r), 14, b));
+			}
+		}
+	}
+	std::vector<ConfigMetrics> metrics;
+	estimatebranches(ids, metrics);
+	EvaluationBatch batch;
+	for (size_t n = 0; n < ids.size(); ++n) {
+		if (0x1f == metrics[n].benchmarks) {
+			batch.add(ids[n], metrics[n]);
+		}
+	}
+	evaluatebatch(batch, 0);
+	const std::vector<double>& objective =
+			optimizeforEDP ? batch.geomeanEDP : batch.geomeanTime;
+	std::vector<std::pair<double, size_t> > ranked;
+	for (size_t n = 0; n < batch.ids.size(); ++n) {
+		ranked.push_back(std::make_pair(objective[n], n));
+	}
+	std::sort(ranked.begin(), ranked.end());
+	// Settings the trace cannot tell apart tie exactly; simulate one of each.
+	std::vector<size_t> verified;
+	for (size_t k = 0; k < ranked.size() && verified.size() < BRANCH_VERIFIED;
+			++k) {
+		if (!k || ranked[k].first != ranked[k - 1].first) {
+			verified.push_back(ranked[k].second);
+		}
+	}
+	for (size_t v = 0; v < verified.size(); ++v) {
+		submitexperiments(unpackconfiguration(batch.ids[verified[v]]));
+	}
+	for (size_t v = 0; v < verified.size(); ++v) {
+		waitexperiments(unpackconfiguration(batch.ids[verified[v]]));
+	}
+	out << "config,normEDP,normTime,EDP,Time,measured EDP,measured Time"
+			<< std::endl;
+	for (size_t k = 0; k < ranked.size(); ++k) {
+		size_t n = ranked[k].second;
+		out << unpackconfiguration(batch.ids[n]) << ","
+				<< batch.geomeanEDP[n] / GLOB_baseline_EP_pair.first << ","
+				<< batch.geomeanTime[n] / GLOB_baseline_EP_pair.second << ","
+				<< batch.geomeanEDP[n] << "," << batch.geomeanTime[n] << ",";
+		if (isconfigurationsimulated(batch.ids[n])) {
+			if (!isconfigurationloaded(unpackconfiguration(batch.ids[n]))) {
+				loadresults(unpackconfiguration(batch.ids[n]));
+			}
+			out << calculategeomeanEDP(batch.ids[n]) << ","
+					<< calculategeomeanExecutionTime(batch.ids[n]);
+		} else {
+			out << ",";
+		}
+		out << std::endl;
+	}
+	out << "Simulated the " << verified.size() << " best distinct estimates of "
+			<< ranked.size() << " branch settings" << std::endl;
+}
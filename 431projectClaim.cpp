@@ -0,0 +1,107 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <vector>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * Claims on simulation jobs, shared by every DSE process whose
+ * GLOB_outputpath is the same directory, on this host or another one that
+ * mounts it.
+ *
+ * A claim is an fcntl() write lock on one byte of GLOB_outputpath/claims.lock,
+ * at an offset hashed from the configuration, benchmark and fidelity. The
+ * kernel drops the locks of a process that dies, and an NFS server those of a
+ * host that stops renewing them, so a claim never outlives its holder and
+ * nothing is left to clean up. Two jobs hashing to the same byte merely take
+ * turns. Locks belong to the process, not to the simulators it forks.
+ */
+
+#define CLAIM_OFFSET_MASK ((1ULL << 62) - 1)
+
+static int claimfd = -1;
+static int claimsopened = 0;
+
+static off_t claimoffset(std::string configuration, int benchmark,
+		unsigned int fidelity) {
+	uint64_t hash = 14695981039346656037ULL; // FNV-1a
+	for (size_t c = 0; c < configuration.size(); ++c) {
+		hash = (hash ^ (unsigned char) configuration[c]) * 1099511628211ULL;
+	}
+	hash = (hash ^ benchmark) * 1099511628211ULL;
+	hash = (hash ^ fidelity) * 1099511628211ULL;
+	return hash & CLAIM_OFFSET_MASK;
+}
+
+/*
+ * The claims file, opened on first use; without one every claim succeeds, as
+ * it did before claims existed.
+ */
+static int claimsfile() {
+	if (!claimsopened) {
+		claimsopened = 1;
+		std::string path = GLOB_outputpath + "claims.lock";
+		claimfd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		if (claimfd < 0) {
+			std::cerr << "Cannot open " << path
+					<< ", simulations are not coordinated with other processes"
+					<< std::endl;
+		}
+	}
+	return claimfd;
+}
+
+static void claimrange(struct flock& lock, short type, std::string configuration,
+		int benchmark, unsigned int fidelity) {
+	memset(&lock, 0, sizeof(lock));
+	lock.l_type = type;
+	lock.l_whence = SEEK_SET;
+	lock.l_start = claimoffset(configuration, benchmark, fidelity);
+	lock.l_len = 1;
+}
+
+int claimbenchmark(std::string configuration, int benchmark,
+		unsigned int fidelity) {
+	if (claimsfile() < 0) {
+		return 1;
+	}
+	struct flock lock;
+	claimrange(lock, F_WRLCK, configuration, benchmark, fidelity);
+	while (0 != fcntl(claimfd, F_SETLK, &lock)) {
+		if (EACCES == errno || EAGAIN == errno) {
+			return 0;
+		}
+		if (EINTR != errno) {
+			return 1; // the lock service is down: run it rather than stall
+		}
+	}
+	return 1;
+}
+
+int isbenchmarkclaimed(std::string configuration, int benchmark,
+		unsigned int fidelity) {
+	if (claimsfile() < 0) {
+		return 0;
+	}
+	struct flock lock;
+	claimrange(lock, F_WRLCK, configuration, benchmark, fidelity);
+	// F_GETLK reports locks of other processes only
+	return 0 == fcntl(claimfd, F_GETLK, &lock) && F_UNLCK != lock.l_type;
+}
+
+void releasebenchmark(std::string configuration, int benchmark,
+		unsigned int fidelity) {
+	if (claimfd < 0) {
+		return;
+	}
+	struct flock lock;
+	claimrange(lock, F_UNLCK, configuration, benchmark, fidelity);
+	fcntl(claimfd, F_SETLK, &lock);
+}
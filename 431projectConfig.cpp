@@ -0,0 +1,32 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "431project.h"
+
+/*
+ * Packed configurations.
+ */
+
+ConfigId packconfiguration(const std::string& configuration) {
+	ConfigId id = 0;
+	for (int dim = 0; dim < NUM_DIMS; ++dim) {
+		// Read like extractConfigPararm(), so half-built configurations (only
+		// the independent dimensions filled in) pack with zero latencies.
+		id = setconfigparam(id, dim, extractConfigPararm(configuration, dim));
+	}
+	return id;
+}
+
+std::string unpackconfiguration(ConfigId id) {
+	std::string configuration(NUM_DIMS * 2 - 1, ' ');
+	for (int dim = 0; dim < NUM_DIMS; ++dim) {
+		configuration[2 * dim] = '0' + configparam(id, dim);
+	}
+	return configuration;
+}
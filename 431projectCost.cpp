@@ -0,0 +1,271 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <time.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * Simulation cost model and search budgets.
+ *
+ * How long sim-outorder takes depends on the configuration: a wide or
+ * out-of-order core steps through more work per cycle, and large caches cost
+ * more per access. Each benchmark has its own ridge regression of log
+ * CPU-seconds per full-window job on an intercept, one-hot width, scheduling,
+ * fpwidth and branchsettings, the log2 dl1, il1 and ul2 sizes, and whether
+ * the sample was recorded rather than measured. The first prediction seeds
+ * the models with every .simout on record, taking sim_num_insn /
+ * sim_inst_rate (sim_elapsed_time where the rate is missing) as recorded
+ * seconds; every job the pool reaps after that adds a measured sample, and
+ * predictions are for measured seconds. A benchmark without samples is
+ * predicted at its GLOB_benchmark_seconds.
+ *
+ * A budgeted search stops proposing once GLOB_simulation_spent reaches the
+ * CPU-seconds budget or the run reaches its deadline; jobs still running
+ * then finish, so either may overrun by the proposal in flight. The rate of
+ * spending since the first proposal projects when that happens.
+ */
+
+#define COST_PRIOR 1.0 // prior precision of every non-intercept weight
+
+static const int costDims[4] = { 0, 1, 11, 12 }; // one-hot
+static const int costFeatures = 1 + (4 - 1) + (2 - 1) + (4 - 1) + (5 - 1) + 3
+		+ 1;
+
+struct CostModel {
+	double gram[costFeatures * costFeatures]; // X^T X, lower triangle
+	double projection[costFeatures]; // X^T log seconds
+	double weights[costFeatures];
+	unsigned int samples;
+	int fitted; // weights reflect every sample
+};
+
+static CostModel costModels[NUM_BENCHMARKS];
+static int costsSeeded = 0;
+static double predictionError = 0; // summed |log(measured / predicted)|
+static unsigned int predictionsChecked = 0;
+
+static double budgetCPU = 0;
+static double budgetWall = 0;
+static double budgetStart = 0; // telemetryclock() at setsearchbudget()
+static double rateStart = -1; // clock and spending at the first proposal
+static double rateSpent = 0;
+static unsigned int budgetProposals = 0; // since rateStart
+
+static void costfeatures(ConfigId id, int recorded, double features[]) {
+	int f = 0;
+	features[f++] = 1.0;
+	for (int d = 0; d < 4; ++d) {
+		for (unsigned int value = 1;
+				value < GLOB_dimensioncardinality[costDims[d]]; ++value) {
+			features[f++] = (value == configparam(id, costDims[d])) ? 1.0 : 0.0;
+		}
+	}
+	features[f++] = __builtin_ctz(getdl1size(id)) - 10;
+	features[f++] = __builtin_ctz(getil1size(id)) - 10;
+	features[f++] = __builtin_ctz(getl2size(id)) - 10;
+	features[f++] = recorded;
+}
+
+static void addcostsample(ConfigId id, int benchmark, int recorded,
+		double seconds) {
+	CostModel& model = costModels[benchmark];
+	double features[costFeatures];
+	costfeatures(id, recorded, features);
+	double target = log(seconds);
+	for (int r = 0; r < costFeatures; ++r) {
+		for (int c = 0; c <= r; ++c) {
+			model.gram[r * costFeatures + c] += features[r] * features[c];
+		}
+		model.projection[r] += features[r] * target;
+	}
+	model.samples++;
+	model.fitted = 0;
+}
+
+/*
+ * Solves (X^T X + prior) w = X^T y by Cholesky.
+ */
+static void fitcosts(CostModel& model) {
+	const int p = costFeatures;
+	double factor[costFeatures * costFeatures];
+	for (int r = 0; r < p; ++r) {
+		for (int c = 0; c <= r; ++c) {
+			double sum = model.gram[r * p + c];
+			if (r == c) {
+				sum += (0 == r) ? 1e-9 : COST_PRIOR;
+			}
+			for (int k = 0; k < c; ++k) {
+				sum -= factor[r * p + k] * factor[c * p + k];
+			}
+			factor[r * p + c] = (r == c) ? sqrt(sum) : sum / factor[c * p + c];
+		}
+	}
+	std::copy(model.projection, model.projection + p, model.weights);
+	for (int r = 0; r < p; ++r) {
+		for (int c = 0; c < r; ++c) {
+			model.weights[r] -= factor[r * p + c] * model.weights[c];
+		}
+		model.weights[r] /= factor[r * p + r];
+	}
+	for (int r = p - 1; r >= 0; --r) {
+		for (int c = r + 1; c < p; ++c) {
+			model.weights[r] -= factor[c * p + r] * model.weights[c];
+		}
+		model.weights[r] /= factor[r * p + r];
+	}
+	model.fitted = 1;
+}
+
+static void seedcosts() {
+	costsSeeded = 1;
+	std::vector<std::string> names;
+	listoutputs(names);
+	unsigned int seeded = 0;
+	for (size_t n = 0; n < names.size(); ++n) {
+		int benchmark;
+		ConfigId id;
+		double values[7];
+		double speed[2];
+		std::string error;
+		if (!traceconfiguration(names[n], ".simout", &benchmark, &id)
+				|| SIMOUT_OK
+						!= parsesimout(GLOB_outputpath + names[n], values,
+								error, speed)) {
+			continue;
+		}
+		double seconds = (speed[1] > 0) ?
+				values[FIELD_SIM_NUM_INSN] / speed[1] : speed[0];
+		if (seconds > 0) {
+			addcostsample(id, benchmark, 1, seconds);
+			seeded++;
+		}
+	}
+	std::cout << "Cost model seeded with " << seeded << " recorded runs"
+			<< std::endl;
+}
+
+static double predictbenchmarkseconds(ConfigId id, int benchmark) {
+	if (!costsSeeded) {
+		seedcosts();
+	}
+	CostModel& model = costModels[benchmark];
+	if (0 == model.samples) {
+		return GLOB_benchmark_seconds[benchmark];
+	}
+	if (!model.fitted) {
+		fitcosts(model);
+	}
+	double features[costFeatures];
+	costfeatures(id, 0, features);
+	double mean = 0;
+	for (int f = 0; f < costFeatures; ++f) {
+		mean += features[f] * model.weights[f];
+	}
+	return exp(mean);
+}
+
+void recordsimulationcost(ConfigId id, int benchmark, double seconds) {
+	if (!(seconds > 0)) {
+		return;
+	}
+	if (costsSeeded && costModels[benchmark].samples) { // how well foreseen
+		predictionError += fabs(
+				log(seconds / predictbenchmarkseconds(id, benchmark)));
+		predictionsChecked++;
+	}
+	addcostsample(id, benchmark, 0, seconds);
+}
+
+double predictsimulationseconds(ConfigId id) {
+	unsigned int stored = lookupresults(id, NULL);
+	double seconds = 0;
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		if (!(stored & (1 << i))) {
+			seconds += predictbenchmarkseconds(id, i);
+		}
+	}
+	return seconds;
+}
+
+void setsearchbudget(double cpuseconds, double wallseconds) {
+	budgetCPU = cpuseconds;
+	budgetWall = wallseconds;
+	budgetStart = telemetryclock();
+}
+
+int budgetedsearch() {
+	return budgetCPU > 0 || budgetWall > 0;
+}
+
+int withinbudget() {
+	double now = telemetryclock();
+	if (rateStart < 0) {
+		rateStart = now;
+		rateSpent = GLOB_simulation_spent;
+	}
+	return (budgetCPU <= 0 || GLOB_simulation_spent < budgetCPU)
+			&& (budgetWall <= 0 || now - budgetStart < budgetWall);
+}
+
+void printbudgetprojection(std::ostream& out) {
+	budgetProposals++;
+	double now = telemetryclock();
+	double elapsed = now - budgetStart;
+	double left = -1; // seconds until a bound is reached, -1 if unknown
+	if (budgetCPU > 0 && GLOB_simulation_spent > rateSpent) {
+		double rate = (GLOB_simulation_spent - rateSpent) / (now - rateStart);
+		left = std::max(0.0, budgetCPU - GLOB_simulation_spent) / rate;
+	}
+	if (budgetWall > 0) {
+		double wall = std::max(0.0, budgetWall - elapsed);
+		left = (left < 0) ? wall : std::min(left, wall);
+	}
+	char line[160];
+	snprintf(line, sizeof(line), "Budget: %.1f CPU-s", GLOB_simulation_spent);
+	out << line;
+	if (budgetCPU > 0) {
+		snprintf(line, sizeof(line), " of %g", budgetCPU);
+		out << line;
+	}
+	snprintf(line, sizeof(line), ", %.1f s", elapsed);
+	out << line;
+	if (budgetWall > 0) {
+		snprintf(line, sizeof(line), " of %g", budgetWall);
+		out << line;
+	}
+	if (left >= 0) {
+		time_t end = time(NULL) + (time_t) ceil(left);
+		char clock[16];
+		strftime(clock, sizeof(clock), "%H:%M:%S", localtime(&end));
+		snprintf(line, sizeof(line), "; projected to end in %.0f s, at %s",
+				left, clock);
+		out << line;
+		if (now > rateStart) {
+			snprintf(line, sizeof(line), ", after about %.0f more proposals",
+					budgetProposals * left / (now - rateStart));
+			out << line;
+		}
+	}
+	out << std::endl;
+}
+
+void printbudgetsummary(std::ostream& out) {
+	char line[160];
+	snprintf(line, sizeof(line),
+			"Spent %.1f CPU-s of simulation in %.1f s", GLOB_simulation_spent,
+			telemetryclock() - budgetStart);
+	out << line << std::endl;
+	if (predictionsChecked) {
+		snprintf(line, sizeof(line),
+				"Cost predictions were off by a factor of %.2f (geomean) over "
+						"%u jobs", exp(predictionError / predictionsChecked),
+				predictionsChecked);
+		out << line << std::endl;
+	}
+}
@@ -0,0 +1,307 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * Main-effects screening of the exploration dimensions.
+ *
+ * One-at-a-time design around the baseline at the shortest screening window:
+ * every independent dimension in turn takes its lowest and its highest value
+ * that keep the baseline valid, the others stay put. Its effect on an
+ * objective is the range of the log geomean over those runs and the baseline,
+ * so an optimum in the middle still counts. The EFFECT_CROSSED strongest
+ * dimensions are then crossed pairwise at the same two extremes; the 2x2
+ * interaction of a pair is half the difference between the effect of one at
+ * either extreme of the other.
+ *
+ * The sweep plan takes the dimensions by falling effect, leaves out those
+ * below EFFECT_NEGLIGIBLE, and sweeps a pair jointly, at the place of its
+ * stronger member, when their interaction reaches EFFECT_JOINT of the weaker
+ * one's effect; a dimension joins one pair at most, strongest interaction
+ * first. Dimensions that cannot be measured go last: those the baseline
+ * leaves no room to vary, those the simulator ignores at the baseline (ras
+ * and btb under nottaken, see simulationclass()), and those whose runs failed.
+ */
+
+#define EFFECT_NEGLIGIBLE 0.005 // log geomean, about 0.5%
+#define EFFECT_CROSSED 4
+#define EFFECT_JOINT 0.5
+
+static const int NUM_SWEPT = NUM_DIMS - NUM_DIMS_DEPENDENT;
+static const int effectsLevel = NUM_FIDELITIES - 1;
+
+static std::vector<SweepStep> effectsPlan;
+static double effectsCost = 0;
+
+/*
+ * Runs the configurations at the screening window, all queued first so they
+ * run in parallel, and returns log geomean EDP (objective 0) and time (1) of
+ * each, NaN where a run failed.
+ */
+static void screenruns(const std::vector<ConfigId>& runs,
+		std::vector<double> logs[2]) {
+	for (size_t r = 0; r < runs.size(); ++r) {
+		submitexperiments(unpackconfiguration(runs[r]), 0, effectsLevel);
+	}
+	for (size_t r = 0; r < runs.size(); ++r) {
+		std::string configuration = unpackconfiguration(runs[r]);
+		waitexperiments(configuration, effectsLevel);
+		ConfigId id = setconfigfidelity(runs[r], effectsLevel);
+		if (0x1f != loadscreening(id)) {
+			std::cerr << "effects screening run of " << configuration
+					<< " failed" << std::endl;
+			logs[0].push_back(NAN);
+			logs[1].push_back(NAN);
+			continue;
+		}
+		logs[0].push_back(log(calculategeomeanEDP(id)));
+		logs[1].push_back(log(calculategeomeanExecutionTime(id)));
+	}
+	effectsCost += runs.size() * (double) GLOB_fidelityinsts[effectsLevel]
+			/ GLOB_fidelityinsts[0];
+}
+
+static ConfigId withvalue(ConfigId id, int dim, unsigned int value) {
+	return setcachelatencies(setconfigparam(id, dim, value));
+}
+
+/*
+ * Lowest and highest value of dim that keep center valid; returns 0 if it
+ * has no other valid value, or none the simulation of any benchmark tells
+ * apart from center.
+ */
+static int extremes(ConfigId center, int dim, unsigned int level[2]) {
+	int found = 0;
+	int observable = 0;
+	for (unsigned int v = 0; v < GLOB_dimensioncardinality[dim]; ++v) {
+		ConfigId run = withvalue(center, dim, v);
+		if (isvalidconfiguration(run)) {
+			level[1] = v;
+			if (!found++) {
+				level[0] = v;
+			}
+			for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+				observable = observable
+						|| simulationclass(run, i) != simulationclass(center, i);
+			}
+		}
+	}
+	return observable && level[0] != level[1];
+}
+
+struct Interaction {
+	double strength; // relative to the weaker main effect
+	int dims[2];
+	double effect[2]; // EDP, time
+
+	bool operator<(const Interaction& other) const {
+		return strength > other.strength;
+	}
+};
+
+static double weighted(const double effect[2], int optimizeforEDP,
+		int optimizeforEXEC) {
+	return std::max(optimizeforEDP ? effect[0] : 0,
+			optimizeforEXEC ? effect[1] : 0);
+}
+
+double screeneffects(std::ostream& out, int optimizeforEDP,
+		int optimizeforEXEC) {
+	ConfigId center = packconfiguration(GLOB_baseline);
+	unsigned int level[NUM_SWEPT][2];
+	int varies[NUM_SWEPT];
+	size_t runof[NUM_SWEPT][2]; // index into runs, 0 for the baseline
+	std::vector<ConfigId> runs(1, center);
+	for (int d = 0; d < NUM_SWEPT; ++d) {
+		varies[d] = extremes(center, d, level[d]);
+		for (int l = 0; varies[d] && l < 2; ++l) {
+			runof[d][l] = 0;
+			if (level[d][l] != configparam(center, d)) {
+				runof[d][l] = runs.size();
+				runs.push_back(withvalue(center, d, level[d][l]));
+			}
+		}
+	}
+	std::vector<double> logs[2];
+	screenruns(runs, logs);
+
+	// Main effects: the range over the baseline and both extremes.
+	double effect[NUM_SWEPT][2];
+	std::vector<int> ranked; // measured dimensions, strongest first
+	for (int d = 0; d < NUM_SWEPT; ++d) {
+		for (int o = 0; varies[d] && o < 2; ++o) {
+			double y[3] = { logs[o][0], logs[o][runof[d][0]],
+					logs[o][runof[d][1]] };
+			effect[d][o] = *std::max_element(y, y + 3)
+					- *std::min_element(y, y + 3);
+			if (effect[d][o] != effect[d][o]) {
+				varies[d] = 0; // NaN from a failed run: no estimate
+			}
+		}
+		if (varies[d]) {
+			ranked.push_back(d);
+		}
+	}
+	std::vector<std::pair<double, int> > order;
+	for (size_t r = 0; r < ranked.size(); ++r) {
+		order.push_back(std::make_pair(
+				-weighted(effect[ranked[r]], optimizeforEDP, optimizeforEXEC),
+				ranked[r]));
+	}
+	std::stable_sort(order.begin(), order.end());
+	for (size_t r = 0; r < order.size(); ++r) {
+		ranked[r] = order[r].second;
+	}
+
+	// Interactions among the strongest dimensions, at their extremes.
+	std::vector<ConfigId> corners;
+	std::vector<std::pair<int, int> > pairs;
+	size_t crossed = std::min((size_t) EFFECT_CROSSED, ranked.size());
+	for (size_t a = 0; a < crossed; ++a) {
+		for (size_t b = a + 1; b < crossed; ++b) {
+			int da = ranked[a], db = ranked[b];
+			ConfigId corner[4]; // low low, low high, high low, high high
+			int valid = 1;
+			for (int c = 0; c < 4; ++c) {
+				corner[c] = withvalue(
+						setconfigparam(center, da, level[da][c / 2]), db,
+						level[db][c % 2]);
+				valid = valid && isvalidconfiguration(corner[c]);
+			}
+			if (valid) {
+				corners.insert(corners.end(), corner, corner + 4);
+				pairs.push_back(std::make_pair(da, db));
+			}
+		}
+	}
+	std::vector<double> cornerlogs[2];
+	screenruns(corners, cornerlogs);
+	std::vector<Interaction> interactions;
+	for (size_t p = 0; p < pairs.size(); ++p) {
+		Interaction interaction;
+		interaction.dims[0] = pairs[p].first;
+		interaction.dims[1] = pairs[p].second;
+		for (int o = 0; o < 2; ++o) {
+			const double* y = &cornerlogs[o][4 * p];
+			interaction.effect[o] = fabs((y[3] - y[1]) - (y[2] - y[0])) / 2;
+		}
+		double weaker = std::min(
+				weighted(effect[pairs[p].first], optimizeforEDP,
+						optimizeforEXEC),
+				weighted(effect[pairs[p].second], optimizeforEDP,
+						optimizeforEXEC));
+		interaction.strength = weaker > 0 ?
+				weighted(interaction.effect, optimizeforEDP, optimizeforEXEC)
+						/ weaker : 0;
+		if (interaction.strength == interaction.strength) { // NaN: failed
+			interactions.push_back(interaction);
+		}
+	}
+	std::stable_sort(interactions.begin(), interactions.end());
+
+	// The plan: by falling effect, negligible dimensions out, pairs joint.
+	int partner[NUM_SWEPT];
+	for (int d = 0; d < NUM_SWEPT; ++d) {
+		partner[d] = -1;
+	}
+	for (size_t i = 0; i < interactions.size(); ++i) {
+		int a = interactions[i].dims[0], b = interactions[i].dims[1];
+		if (interactions[i].strength >= EFFECT_JOINT && partner[a] < 0
+				&& partner[b] < 0) {
+			partner[a] = b;
+			partner[b] = a;
+		}
+	}
+	effectsPlan.clear();
+	std::vector<int> skipped;
+	for (size_t r = 0; r < ranked.size(); ++r) {
+		int d = ranked[r];
+		SweepStep step = { d, partner[d] };
+		if (partner[d] >= 0) {
+			if (std::find(ranked.begin(), ranked.begin() + r, partner[d])
+					== ranked.begin() + r) { // not swept with the stronger yet
+				effectsPlan.push_back(step);
+			}
+		} else if (r > 0
+				&& weighted(effect[d], optimizeforEDP, optimizeforEXEC)
+						< EFFECT_NEGLIGIBLE) {
+			skipped.push_back(d); // the strongest stays, however weak
+		} else {
+			effectsPlan.push_back(step);
+		}
+	}
+	for (int d = 0; d < NUM_SWEPT; ++d) {
+		if (!varies[d]) {
+			SweepStep step = { d, -1 };
+			effectsPlan.push_back(step);
+		}
+	}
+
+	char row[96];
+	out << "Main effects at " << GLOB_fidelityinsts[effectsLevel]
+			<< " instructions, range of log geomean:" << std::endl
+			<< "  dimension                          EDP      time" << std::endl;
+	for (int d = 0; d < NUM_SWEPT; ++d) {
+		if (varies[d]) {
+			snprintf(row, sizeof(row), "  %-29s %8.4f  %8.4f",
+					GLOB_dimensionnames[d].c_str(), effect[d][0], effect[d][1]);
+		} else {
+			snprintf(row, sizeof(row), "  %-29s        -         -",
+					GLOB_dimensionnames[d].c_str());
+		}
+		out << row << std::endl;
+	}
+	for (size_t i = 0; i < interactions.size(); ++i) {
+		std::string pair = GLOB_dimensionnames[interactions[i].dims[0]] + " x "
+				+ GLOB_dimensionnames[interactions[i].dims[1]];
+		snprintf(row, sizeof(row), "  %-29s %8.4f  %8.4f%s", pair.c_str(),
+				interactions[i].effect[0], interactions[i].effect[1],
+				partner[interactions[i].dims[0]] == interactions[i].dims[1] ?
+						"  joint" : "");
+		out << row << std::endl;
+	}
+	out << "Sweep plan:";
+	for (size_t s = 0; s < effectsPlan.size(); ++s) {
+		out << (s ? ", " : " ") << GLOB_dimensionnames[effectsPlan[s].dim];
+		if (effectsPlan[s].partner >= 0) {
+			out << "+" << GLOB_dimensionnames[effectsPlan[s].partner];
+		}
+	}
+	out << std::endl << "Skipped:";
+	for (size_t s = 0; s < skipped.size(); ++s) {
+		out << (s ? ", " : " ") << GLOB_dimensionnames[skipped[s]];
+	}
+	out << std::endl << "Screening cost: " << runs.size() + corners.size()
+			<< " runs, " << effectsCost << " full-run equivalents" << std::endl
+			<< std::endl;
+
+	setsweepplan(effectsPlan);
+	return effectsCost;
+}
+
+void printeffectssavings(std::ostream& out) {
+	unsigned int planned = 0;
+	unsigned int full = 0;
+	for (size_t s = 0; s < effectsPlan.size(); ++s) {
+		planned += GLOB_dimensioncardinality[effectsPlan[s].dim]
+				* (effectsPlan[s].partner < 0 ?
+						1 : GLOB_dimensioncardinality[effectsPlan[s].partner])
+				- 1;
+	}
+	for (int d = 0; d < NUM_SWEPT; ++d) {
+		full += GLOB_dimensioncardinality[d] - 1;
+	}
+	unsigned int traversals = heuristictraversals();
+	out << "Effects screening cost " << effectsCost
+			<< " full-run equivalents; the sweep plan proposes up to " << planned
+			<< " configurations per traversal against " << full
+			<< ", " << (int) (full - planned) * (int) traversals
+			<< " fewer over " << traversals << " traversals" << std::endl;
+}
@@ -0,0 +1,228 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * Genetic search.
+ *
+ * Generational, with the parents drawn from everything the search has seen:
+ * the population is the GENETIC_POPULATION best complete configurations in
+ * GLOB_extracted_values that are marked seen, so every result, cached or
+ * simulated, competes, and the best survive from one generation to the next
+ * without being simulated again. A generation is GENETIC_POPULATION children,
+ * bred at once and proposed in turn; peekGeneticProposals() hands out the rest
+ * of it, which main queues for the pool so the whole generation simulates in
+ * parallel.
+ *
+ * Each child takes the independent dimensions of two tournament winners,
+ * gene by gene from either at random, then has each gene redrawn with
+ * probability 1 / GENETIC_GENES. Crossover retries its draw until the child
+ * is valid, and mutation only draws values that keep it valid, so every child
+ * passes validateConfiguration(). A child already seen, or already in the
+ * generation, is mutated further until it is new. Until the population holds
+ * GENETIC_POPULATION / 2 configurations, children are uniform samples of the
+ * design space instead. A search whose objective alternates, as the pareto
+ * mode's does, breeds the children from the best by either objective in turn.
+ *
+ * The generation in progress is not journaled: a resumed search breeds a new
+ * one from the configurations it has seen.
+ */
+
+#define GENETIC_TOURNAMENT 2 // entrants per parent selection
+#define GENETIC_ATTEMPTS 64 // draws before falling back
+
+static const int GENETIC_GENES = NUM_DIMS - NUM_DIMS_DEPENDENT;
+
+struct GeneticState {
+	unsigned int generation;
+	int objectives; // asked for so far: 1 EDP, 2 time
+	std::vector<ConfigId> children;
+	size_t next; // first child not proposed yet
+};
+
+static GeneticState genetic = { 0, 0, std::vector<ConfigId>(), 0 };
+
+/*
+ * The best GENETIC_POPULATION seen configurations with complete, sane
+ * results, best first.
+ */
+static void selectpopulation(int optimizeforEDP,
+		std::vector<ConfigId>& population) {
+	static int resumeLoaded = 0;
+	if (!resumeLoaded) { // a resumed search has seen more than it loaded
+		std::vector<ConfigId> stored;
+		storedconfigurationids(stored);
+		for (size_t n = 0; n < stored.size(); ++n) {
+			if (isconfigurationseen(stored[n])
+					&& isconfigurationsimulated(stored[n])
+					&& !isconfigurationloaded(unpackconfiguration(stored[n]))) {
+				loadresults(unpackconfiguration(stored[n]));
+			}
+		}
+		resumeLoaded = 1;
+	}
+	EvaluationBatch batch;
+	for (size_t slot = 0; slot < GLOB_extracted_values.keys.size(); ++slot) {
+		ConfigId id = GLOB_extracted_values.keys[slot];
+		const ConfigMetrics& metrics = GLOB_extracted_values.values[slot];
+		if (NO_CONFIG == id || 0x1f != metrics.benchmarks
+				|| !isconfigurationseen(id)) {
+			continue;
+		}
+		int broken = 0;
+		for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+			broken = broken || 0 == metrics.values[i][FIELD_SIM_NUM_INSN];
+		}
+		if (!broken) {
+			batch.add(id, metrics);
+		}
+	}
+	evaluatebatch(batch);
+	const std::vector<double>& objective =
+			optimizeforEDP ? batch.geomeanEDP : batch.geomeanTime;
+	std::vector<std::pair<double, ConfigId> > ranked;
+	for (size_t n = 0; n < batch.ids.size(); ++n) {
+		ranked.push_back(std::make_pair(objective[n], batch.ids[n]));
+	}
+	std::sort(ranked.begin(), ranked.end());
+	for (size_t n = 0; n < ranked.size() && n < GENETIC_POPULATION; ++n) {
+		population.push_back(ranked[n].second);
+	}
+}
+
+/*
+ * Population is sorted best first, so the lowest index drawn wins.
+ */
+static ConfigId tournament(const std::vector<ConfigId>& population) {
+	size_t winner = rand() % population.size();
+	for (int t = 1; t < GENETIC_TOURNAMENT; ++t) {
+		winner = std::min(winner, (size_t) (rand() % population.size()));
+	}
+	return population[winner];
+}
+
+static ConfigId crossover(ConfigId a, ConfigId b) {
+	for (int attempt = 0; attempt < GENETIC_ATTEMPTS; ++attempt) {
+		ConfigId child = a;
+		for (int dim = 0; dim < GENETIC_GENES; ++dim) {
+			if (rand() & 1) {
+				child = setconfigparam(child, dim, configparam(b, dim));
+			}
+		}
+		child = setcachelatencies(child);
+		if (isvalidconfiguration(child)) {
+			return child;
+		}
+	}
+	return a;
+}
+
+/*
+ * Redraws one gene among the other values that keep id valid; id itself if
+ * there are none.
+ */
+static ConfigId mutate(ConfigId id, int dim) {
+	std::vector<ConfigId> alleles;
+	for (unsigned int value = 0; value < GLOB_dimensioncardinality[dim];
+			++value) {
+		ConfigId mutant = setcachelatencies(setconfigparam(id, dim, value));
+		if (value != configparam(id, dim) && isvalidconfiguration(mutant)) {
+			alleles.push_back(mutant);
+		}
+	}
+	return alleles.empty() ? id : alleles[rand() % alleles.size()];
+}
+
+static int isnewchild(ConfigId id, const std::vector<ConfigId>& children) {
+	return !isconfigurationseen(id)
+			&& children.end() == std::find(children.begin(), children.end(), id);
+}
+
+/*
+ * Replaces the children with the next generation; returns how many it bred.
+ */
+static size_t breedgeneration() {
+	std::vector<std::vector<ConfigId> > populations;
+	for (int objective = 0; objective < 2; ++objective) {
+		if (genetic.objectives & (1 << objective)) {
+			populations.push_back(std::vector<ConfigId>());
+			selectpopulation(0 == objective, populations.back());
+		}
+	}
+	genetic.children.clear();
+	genetic.next = 0;
+	genetic.generation++;
+	for (unsigned int c = 0; c < GENETIC_POPULATION; ++c) {
+		const std::vector<ConfigId>& population =
+				populations[c % populations.size()];
+		ConfigId child = NO_CONFIG;
+		if (2 * population.size() >= GENETIC_POPULATION) {
+			child = crossover(tournament(population), tournament(population));
+			for (int dim = 0; dim < GENETIC_GENES; ++dim) {
+				if (0 == rand() % GENETIC_GENES) {
+					child = mutate(child, dim);
+				}
+			}
+			for (int attempt = 0;
+					attempt < GENETIC_ATTEMPTS
+							&& !isnewchild(child, genetic.children); ++attempt) {
+				child = mutate(child, rand() % GENETIC_GENES);
+			}
+		}
+		for (int attempt = 0;
+				attempt < GENETIC_ATTEMPTS
+						&& (NO_CONFIG == child
+								|| !isnewchild(child, genetic.children));
+				++attempt) {
+			child = sampleconfiguration();
+		}
+		if (NO_CONFIG != child && isnewchild(child, genetic.children)) {
+			genetic.children.push_back(child);
+		}
+	}
+	return genetic.children.size();
+}
+
+std::string generateGeneticProposal(std::string currentconfiguration,
+		std::string /* bestEXECconfiguration */,
+		std::string /* bestEDPconfiguration */, int /* optimizeforEXEC */,
+		int optimizeforEDP) {
+	genetic.objectives |= optimizeforEDP ? 1 : 2;
+	for (;;) {
+		// Screening brackets may have seen some of the generation already.
+		while (genetic.next < genetic.children.size()) {
+			ConfigId child = genetic.children[genetic.next++];
+			if (!isconfigurationseen(child)) {
+				return unpackconfiguration(child);
+			}
+		}
+		if (0 == breedgeneration()) {
+			return currentconfiguration; // nothing new left to breed
+		}
+	}
+}
+
+void peekGeneticProposals(std::string nextconfiguration,
+		std::string /* bestEXECconfiguration */,
+		std::string /* bestEDPconfiguration */, int /* optimizeforEXEC */,
+		int /* optimizeforEDP */, unsigned int count,
+		std::vector<std::string>& proposals) {
+	ConfigId next = packconfiguration(nextconfiguration);
+	for (size_t n = genetic.next;
+			n < genetic.children.size() && proposals.size() < count; ++n) {
+		if (next != genetic.children[n]
+				&& !isconfigurationseen(genetic.children[n])) {
+			proposals.push_back(unpackconfiguration(genetic.children[n]));
+		}
+	}
+}
+
+unsigned int geneticgenerations() {
+	return genetic.generation;
+}
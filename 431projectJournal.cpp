@@ -0,0 +1,187 @@
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <fstream>
+#include <vector>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * Search journal.
+ *
+ * One line per event, appended and synced before the search moves on:
+ *
+ *   dse <target> <search options>     first line, written on a fresh start
+ *   iter <fields separated by '|'>    the SearchProgress after an iteration
+ *   end                               the search finished
+ *
+ * A journal that ends in "end", or was written with other options, starts
+ * the search over. Otherwise the last iter line is the state to continue from
+ * and the configurations every iter line lists as seen are replayed into the
+ * seen set, so a configuration is used up only together with the progress
+ * that accounts for it; a torn last line is ignored, and cut off before the
+ * resumed search appends to the journal. Simulation results are not
+ * journaled: the result store records each benchmark as it finishes, so the
+ * pool only reruns the missing ones.
+ */
+
+static int journalfd = -1;
+
+static void appendline(const std::string& line) {
+	std::string record = line + "\n";
+	// one write per line, so a crash tears at most the last one
+	if (journalfd < 0
+			|| (ssize_t) record.size()
+					!= write(journalfd, record.data(), record.size())) {
+		std::cerr << "Cannot write the search journal" << std::endl;
+		return;
+	}
+	fdatasync(journalfd);
+}
+
+static std::string formatdouble(double value) {
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.17g", value);
+	return buffer;
+}
+
+static void splitfields(const std::string& line, char separator,
+		std::vector<std::string>& fields) {
+	std::stringstream stream(line);
+	std::string field;
+	while (std::getline(stream, field, separator)) {
+		fields.push_back(field);
+	}
+}
+
+/*
+ * Parses the fields of an iter line, returns 0 if malformed.
+ */
+static int parseprogress(const std::string& record, SearchProgress& progress) {
+	std::vector<std::string> fields;
+	splitfields(record, '|', fields);
+	if (fields.size() < 8) { // the finalists field may be empty
+		return 0;
+	}
+	std::stringstream counters(fields[0]);
+	SearchProgress parsed;
+	if (!(counters >> parsed.iteration >> parsed.screeningspent
+			>> parsed.logbytes >> parsed.simulationspent)) {
+		return 0;
+	}
+	parsed.current = fields[1];
+	parsed.bestTimeconfig = fields[2];
+	parsed.bestTime = atof(fields[3].c_str());
+	parsed.bestEDPconfig = fields[4];
+	parsed.bestEDP = atof(fields[5].c_str());
+	parsed.explorer = fields[6];
+	if (fields.size() > 8) {
+		splitfields(fields[8], ';', parsed.finalists);
+	}
+	if (fields.size() > 9) {
+		splitfields(fields[9], ';', parsed.seen);
+	}
+	if (!isNumDimConfiguration(parsed.current)
+			|| !isNumDimConfiguration(parsed.bestTimeconfig)
+			|| !isNumDimConfiguration(parsed.bestEDPconfig)
+			|| (size_t) atoi(fields[7].c_str()) != parsed.finalists.size()) {
+		return 0;
+	}
+	for (size_t s = 0; s < parsed.seen.size(); ++s) {
+		if (!isNumDimConfiguration(parsed.seen[s])) {
+			return 0;
+		}
+	}
+	progress = parsed;
+	return 1;
+}
+
+int openjournal(std::string path, std::string header,
+		SearchProgress& progress) {
+	std::ifstream previous(path.c_str());
+	std::vector<std::string> seen;
+	std::string line;
+	int resumable = 0;
+	int first = 1;
+	off_t complete = 0; // bytes up to the last whole line
+	while (std::getline(previous, line)) {
+		if (previous.eof()) {
+			break; // no newline: torn by a crash
+		}
+		complete += line.size() + 1;
+		if (first) {
+			first = 0;
+			if (line != "dse " + header) {
+				break; // other target or search options
+			}
+		} else if (0 == line.compare(0, 5, "iter ")) {
+			SearchProgress parsed;
+			if (parseprogress(line.substr(5), parsed)) {
+				seen.insert(seen.end(), parsed.seen.begin(), parsed.seen.end());
+				progress = parsed;
+				resumable = 1;
+			}
+		} else if ("end" == line) {
+			resumable = 0;
+			seen.clear();
+		}
+	}
+	previous.close();
+	progress.seen.clear();
+	if (resumable && 0 != truncate(path.c_str(), complete)) {
+		resumable = 0; // appending after a torn line would join the two
+	}
+
+	int flags = O_WRONLY | O_CREAT | O_APPEND | (resumable ? 0 : O_TRUNC);
+	journalfd = open(path.c_str(), flags, 0644);
+	if (journalfd < 0) {
+		std::cerr << "Cannot open " << path << ", the search will not resume"
+				<< std::endl;
+		return 0;
+	}
+	if (!resumable) {
+		appendline("dse " + header);
+		return 0;
+	}
+	for (size_t s = 0; s < seen.size(); ++s) {
+		markconfigurationseen(packconfiguration(seen[s]));
+	}
+	return 1;
+}
+
+void journalprogress(const SearchProgress& progress) {
+	std::stringstream record;
+	record << "iter " << progress.iteration << " "
+			<< formatdouble(progress.screeningspent) << " "
+			<< progress.logbytes << " "
+			<< formatdouble(progress.simulationspent) << "|"
+			<< progress.current << "|" << progress.bestTimeconfig << "|"
+			<< formatdouble(progress.bestTime) << "|" << progress.bestEDPconfig
+			<< "|" << formatdouble(progress.bestEDP) << "|" << progress.explorer
+			<< "|" << progress.finalists.size() << "|";
+	for (size_t f = 0; f < progress.finalists.size(); ++f) {
+		record << (f ? ";" : "") << progress.finalists[f];
+	}
+	record << "|";
+	for (size_t s = 0; s < progress.seen.size(); ++s) {
+		record << (s ? ";" : "") << progress.seen[s];
+	}
+	appendline(record.str());
+}
+
+void closejournal(int finished) {
+	if (journalfd < 0) {
+		return;
+	}
+	if (finished) {
+		appendline("end");
+	}
+	close(journalfd);
+	journalfd = -1;
+}
@@ -0,0 +1,375 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <math.h>
+
+#include "431project.h"
+
+/*
+ * Energy and execution time model.
+ *
+ * The technology constants live in GLOB_technology. They are expanded once
+ * into lookup tables indexed by the packed configuration fields, so that
+ * evaluating a configuration is a handful of table reads followed by
+ * straight-line arithmetic. The scalar entry points and evaluatebatch() share
+ * that arithmetic operation for operation and produce identical results.
+ */
+
+TechnologyParams GLOB_technology = {
+		{ { 100e-12, 120e-12, 140e-12, 165e-12 }, // in-order cycle time
+				{ 115e-12, 125e-12, 150e-12, 175e-12 } }, // out-of-order
+		5e-12, // per FP unit
+		{ { 8e-12, 10e-12, 14e-12, 20e-12 }, { 10e-12, 12e-12, 18e-12, 27e-12 } },
+		{ { 1e-3, 1.5e-3, 7e-3, 30e-3 }, { 1.5e-3, 2e-3, 8e-3, 32e-3 } },
+		0.25e-3, // per FP unit
+		{ 8192, 16384, 32768, 65536, 131072, 262144, 524288, 1048576, 2097152 },
+		{ 125e-6, 250e-6, 500e-6, 1e-3, 2e-3, 4e-3, 8e-3, 16e-3, 32e-3, 40e-3 },
+		{ 20e-12, 28e-12, 40e-12, 56e-12, 80e-12, 112e-12, 160e-12, 224e-12,
+				360e-12, 400 - 12 },
+		512e-3, // main memory refresh
+		2e-9 };
+
+unsigned int GLOB_model_generation = 1;
+ConfigTable<DerivedValues> GLOB_derived_values;
+
+// [scheduling][log2 width][log2 fpwidth]
+static double cycleTable[2][4][4];
+static double pipelineLeakTable[2][4][4];
+// [scheduling][log2 width]
+static double epciTable[2][4];
+// [log2 size in bytes]
+static double cacheLeakTable[32];
+static double accessEnergyTable[32];
+
+/*
+ * Per-configuration factors of the model.
+ */
+struct ModelCoefficients {
+	double cycletime; // seconds per cycle
+	double leakage; // watts: pipeline, caches and memory refresh
+	double epci; // joules per committed instruction
+	double il1energy; // joules per access
+	double dl1energy;
+	double ul2energy;
+	double memoryenergy; // joules per ul2 miss or writeback
+};
+
+// leakage in watts
+double getcacheleak(unsigned int size) {
+	int sizeclass = 0;
+	while (sizeclass < 9 && size > GLOB_technology.cachesizelimit[sizeclass]) {
+		++sizeclass;
+	}
+	return GLOB_technology.cacheleak[sizeclass];
+}
+
+//energy per access in joules
+double getaccessenergy(unsigned int size) {
+	int sizeclass = 0;
+	while (sizeclass < 9 && size > GLOB_technology.cachesizelimit[sizeclass]) {
+		++sizeclass;
+	}
+	return GLOB_technology.accessenergy[sizeclass];
+}
+
+static int buildtables() {
+	const TechnologyParams& tech = GLOB_technology;
+	for (int scheduling = 0; scheduling < 2; ++scheduling) {
+		for (int width = 0; width < 4; ++width) {
+			epciTable[scheduling][width] = tech.epci[scheduling][width];
+			for (int fpwidth = 0; fpwidth < 4; ++fpwidth) {
+				cycleTable[scheduling][width][fpwidth] =
+						tech.cycletime[scheduling][width]
+								+ (1 << fpwidth) * tech.fpcycletime;
+				pipelineLeakTable[scheduling][width][fpwidth] =
+						tech.pipelineleak[scheduling][width]
+								+ tech.fpleak * (1 << fpwidth);
+			}
+		}
+	}
+	for (int log2size = 0; log2size < 32; ++log2size) {
+		cacheLeakTable[log2size] = getcacheleak(1u << log2size);
+		accessEnergyTable[log2size] = getaccessenergy(1u << log2size);
+	}
+	return 1;
+}
+
+static int tablesBuilt = buildtables();
+
+void settechnology(const TechnologyParams& params) {
+	GLOB_technology = params;
+	tablesBuilt = buildtables();
+	GLOB_model_generation++; // every memoized value is now stale
+}
+
+static inline int log2size(unsigned int size) {
+	return __builtin_ctz(size); // cache sizes are powers of two
+}
+
+static inline void modelcoefficients(ConfigId id, ModelCoefficients& c) {
+	unsigned int scheduling = configparam(id, 1);
+	unsigned int width = configparam(id, 0);
+	unsigned int fpwidth = configparam(id, 11);
+	int dl1 = log2size(getdl1size(id));
+	int il1 = log2size(getil1size(id));
+	int ul2 = log2size(getl2size(id));
+	c.cycletime = cycleTable[scheduling][width][fpwidth];
+	c.leakage = pipelineLeakTable[scheduling][width][fpwidth]
+			+ (cacheLeakTable[dl1] + cacheLeakTable[il1] + cacheLeakTable[ul2])
+			+ GLOB_technology.memoryrefresh;
+	c.epci = epciTable[scheduling][width];
+	c.il1energy = accessEnergyTable[il1];
+	c.dl1energy = accessEnergyTable[dl1];
+	c.ul2energy = accessEnergyTable[ul2];
+	c.memoryenergy = GLOB_technology.memoryaccess;
+}
+
+/*
+ * Dynamic energy of one benchmark run, in joules.
+ */
+static inline double executionenergy(double epci, double il1energy,
+		double dl1energy, double ul2energy, double memoryenergy,
+		const double insn, const double il1, const double dl1,
+		const double ul2, const double misses, const double writebacks) {
+	return epci * insn + il1energy * il1 + dl1energy * dl1 + ul2energy * ul2
+			+ memoryenergy * (misses + writebacks);
+}
+
+double cycleTime(ConfigId id) {
+	return cycleTable[configparam(id, 1)][configparam(id, 0)][configparam(id,
+			11)];
+}
+
+double EPCI(ConfigId id) {
+	return epciTable[configparam(id, 1)][configparam(id, 0)];
+}
+
+double PipelineLeakage(ConfigId id) {
+	return pipelineLeakTable[configparam(id, 1)][configparam(id, 0)][configparam(
+			id, 11)];
+}
+
+// leakage in watts
+double cacheleak(ConfigId id) {
+	return cacheLeakTable[log2size(getdl1size(id))]
+			+ cacheLeakTable[log2size(getil1size(id))]
+			+ cacheLeakTable[log2size(getl2size(id))];
+}
+
+/*
+ * Counters of one benchmark of a configuration; zeros if never populated.
+ */
+static const double* extractedvalues(ConfigId id, int benchmark) {
+	static const double none[NUM_FIELDS] = { 0 };
+	ConfigMetrics* metrics = GLOB_extracted_values.find(id);
+	return metrics ? metrics->values[benchmark] : none;
+}
+
+/*
+ * Use data in GLOB_extracted_values to calculate execution time, in seconds, of 1 benchmark, on one configuration
+ */
+double calculateExecutionTime(ConfigId id, int benchmark) {
+	return cycleTime(id) * extractedvalues(id, benchmark)[FIELD_SIM_CYCLE];
+}
+
+/*
+ * Use data in GLOB_extracted_values to calculate energy delay product, in
+ * Joule-seconds, of 1 benchmark, on one configuration:
+ * EDP = time * (leakage power * time + dynamic energy).
+ */
+double calculateEDP(ConfigId id, int benchmark) {
+	const double* values = extractedvalues(id, benchmark);
+	ModelCoefficients c;
+	modelcoefficients(id, c);
+	double executiontime = c.cycletime * values[FIELD_SIM_CYCLE];
+	double energy = executiontime * c.leakage
+			+ executionenergy(c.epci, c.il1energy, c.dl1energy, c.ul2energy,
+					c.memoryenergy, values[FIELD_SIM_NUM_INSN],
+					values[FIELD_IL1_ACCESSES], values[FIELD_DL1_ACCESSES],
+					values[FIELD_UL2_ACCESSES], values[FIELD_UL2_MISSES],
+					values[FIELD_UL2_WRITEBACKS]);
+	return executiontime * energy;
+}
+
+/*
+ * Memoized geomeans, refreshed when stale or missing. Only configurations
+ * with all benchmarks loaded are memoized.
+ */
+static const DerivedValues& derivedvalues(ConfigId id, DerivedValues& scratch) {
+	DerivedValues* derived = GLOB_derived_values.find(id);
+	if (derived && GLOB_model_generation == derived->generation) {
+		return *derived;
+	}
+	double geomeanEDP = 1.0;
+	double geomeanTime = 1.0;
+	for (int i = 0; i < 5; ++i) {
+		geomeanEDP *= calculateEDP(id, i);
+		geomeanTime *= calculateExecutionTime(id, i);
+	}
+	scratch.geomeanEDP = pow(geomeanEDP, 1.0 / 5.0);
+	scratch.geomeanTime = pow(geomeanTime, 1.0 / 5.0);
+	scratch.generation = GLOB_model_generation;
+	ConfigMetrics* metrics = GLOB_extracted_values.find(id);
+	if (metrics && 0x1f == metrics->benchmarks) {
+		GLOB_derived_values[id] = scratch;
+	}
+	return scratch;
+}
+
+//Geomean of execution times across benchmarks in a configuration
+double calculategeomeanExecutionTime(ConfigId id) {
+	DerivedValues scratch;
+	return derivedvalues(id, scratch).geomeanTime;
+}
+
+//Geomean of EDP across benchmarks in a configuration
+double calculategeomeanEDP(ConfigId id) {
+	DerivedValues scratch;
+	return derivedvalues(id, scratch).geomeanEDP;
+}
+
+void invalidatederivedvalues(ConfigId id) {
+	DerivedValues* derived = GLOB_derived_values.find(id);
+	if (derived) {
+		derived->generation = 0;
+	}
+}
+
+void EvaluationBatch::add(ConfigId id, const ConfigMetrics& metrics) {
+	ids.push_back(id);
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		for (int j = 0; j < NUM_FIELDS; ++j) {
+			counters[i][j].push_back(metrics.values[i][j]);
+		}
+	}
+}
+
+void EvaluationBatch::clear() {
+	ids.clear();
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		for (int j = 0; j < NUM_FIELDS; ++j) {
+			counters[i][j].clear();
+		}
+	}
+}
+
+void evaluatebatch(EvaluationBatch& batch, int memoize) {
+	size_t count = batch.ids.size();
+
+	// Gather per-configuration factors from the tables into columns.
+	std::vector<double> coefficients(7 * count);
+	double* __restrict cycletime = &coefficients[0];
+	double* __restrict leakage = cycletime + count;
+	double* __restrict epci = leakage + count;
+	double* __restrict il1energy = epci + count;
+	double* __restrict dl1energy = il1energy + count;
+	double* __restrict ul2energy = dl1energy + count;
+	double* __restrict memoryenergy = ul2energy + count;
+	for (size_t n = 0; n < count; ++n) {
+		ModelCoefficients c;
+		modelcoefficients(batch.ids[n], c);
+		cycletime[n] = c.cycletime;
+		leakage[n] = c.leakage;
+		epci[n] = c.epci;
+		il1energy[n] = c.il1energy;
+		dl1energy[n] = c.dl1energy;
+		ul2energy[n] = c.ul2energy;
+		memoryenergy[n] = c.memoryenergy;
+	}
+
+	batch.geomeanTime.assign(count, 1.0);
+	batch.geomeanEDP.assign(count, 1.0);
+	double* __restrict geomeanTime = count ? &batch.geomeanTime[0] : NULL;
+	double* __restrict geomeanEDP = count ? &batch.geomeanEDP[0] : NULL;
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		batch.time[i].resize(count);
+		batch.edp[i].resize(count);
+		if (0 == count) {
+			continue;
+		}
+		double* __restrict time = &batch.time[i][0];
+		double* __restrict edp = &batch.edp[i][0];
+		const double* __restrict insn = &batch.counters[i][FIELD_SIM_NUM_INSN][0];
+		const double* __restrict cycles = &batch.counters[i][FIELD_SIM_CYCLE][0];
+		const double* __restrict il1 = &batch.counters[i][FIELD_IL1_ACCESSES][0];
+		const double* __restrict dl1 = &batch.counters[i][FIELD_DL1_ACCESSES][0];
+		const double* __restrict ul2 = &batch.counters[i][FIELD_UL2_ACCESSES][0];
+		const double* __restrict misses = &batch.counters[i][FIELD_UL2_MISSES][0];
+		const double* __restrict writebacks =
+				&batch.counters[i][FIELD_UL2_WRITEBACKS][0];
+		// Straight-line, branch-free body: vectorised by the compiler.
+		for (size_t n = 0; n < count; ++n) {
+			double t = cycletime[n] * cycles[n];
+			double energy = t * leakage[n]
+					+ executionenergy(epci[n], il1energy[n], dl1energy[n],
+							ul2energy[n], memoryenergy[n], insn[n], il1[n],
+							dl1[n], ul2[n], misses[n], writebacks[n]);
+			time[n] = t;
+			edp[n] = t * energy;
+			geomeanTime[n] *= t;
+			geomeanEDP[n] *= edp[n];
+		}
+	}
+	for (size_t n = 0; n < count; ++n) {
+		geomeanTime[n] = pow(geomeanTime[n], 1.0 / 5.0);
+		geomeanEDP[n] = pow(geomeanEDP[n], 1.0 / 5.0);
+	}
+	for (size_t n = 0; memoize && n < count; ++n) {
+		DerivedValues& derived = GLOB_derived_values[batch.ids[n]];
+		derived.geomeanEDP = geomeanEDP[n];
+		derived.geomeanTime = geomeanTime[n];
+		derived.generation = GLOB_model_generation;
+	}
+}
+
+unsigned int evaluatehistory(EvaluationBatch& batch) {
+	std::vector<ConfigId> ids;
+	storedconfigurationids(ids);
+	std::sort(ids.begin(), ids.end());
+	batch.clear();
+	ConfigMetrics metrics;
+	for (size_t n = 0; n < ids.size(); ++n) {
+		metrics.benchmarks = lookupresults(ids[n], metrics.values);
+		if (0x1f == metrics.benchmarks) {
+			batch.add(ids[n], metrics);
+		}
+	}
+	evaluatebatch(batch);
+	return batch.ids.size();
+}
+
+struct RankOrder {
+	const std::vector<double>* objective;
+	bool operator()(size_t a, size_t b) const {
+		return (*objective)[a] < (*objective)[b];
+	}
+};
+
+void printranking(std::ostream& out, int optimizeforEDP, unsigned int count) {
+	EvaluationBatch batch;
+	evaluatehistory(batch);
+	std::vector<size_t> order(batch.ids.size());
+	for (size_t n = 0; n < order.size(); ++n) {
+		order[n] = n;
+	}
+	RankOrder rank;
+	rank.objective = optimizeforEDP ? &batch.geomeanEDP : &batch.geomeanTime;
+	std::stable_sort(order.begin(), order.end(), rank);
+	if (count > order.size()) {
+		count = order.size();
+	}
+	for (unsigned int r = 0; r < count; ++r) {
+		size_t n = order[r];
+		out << unpackconfiguration(batch.ids[n]) << ","
+				<< batch.geomeanEDP[n] / GLOB_baseline_EP_pair.first << ","
+				<< batch.geomeanTime[n] / GLOB_baseline_EP_pair.second << ","
+				<< batch.geomeanEDP[n] << "," << batch.geomeanTime[n]
+				<< std::endl;
+	}
+}
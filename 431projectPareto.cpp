@@ -0,0 +1,72 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * Pareto front of (geomean execution time, geomean energy) over the
+ * configurations a search has evaluated. Kept sorted by time, so energy falls
+ * strictly along it; a configuration joins unless one already on the front is
+ * no slower and no hungrier, and pushes out those it beats on both.
+ *
+ * The geomean energy is the geomean EDP over the geomean time, as every
+ * benchmark's EDP is its energy times its time.
+ */
+
+struct ParetoPoint {
+	double time;
+	double energy;
+	ConfigId id;
+};
+
+static std::vector<ParetoPoint> paretoFront;
+
+static bool fasterthan(const ParetoPoint& point, double time) {
+	return point.time < time;
+}
+
+int updateparetofront(ConfigId id) {
+	ParetoPoint point;
+	point.time = calculategeomeanExecutionTime(id);
+	point.energy = calculategeomeanEDP(id) / point.time;
+	point.id = id;
+	if (!(point.time > 0 && point.energy > 0)) {
+		return 0; // NaN from a broken run compares false against everything
+	}
+	std::vector<ParetoPoint>::iterator at = std::lower_bound(
+			paretoFront.begin(), paretoFront.end(), point.time, fasterthan);
+	if ((at != paretoFront.begin() && (at - 1)->energy <= point.energy)
+			|| (at != paretoFront.end() && at->time == point.time
+					&& at->energy <= point.energy)) {
+		return 0; // dominated, or already there
+	}
+	std::vector<ParetoPoint>::iterator beaten = at;
+	while (beaten != paretoFront.end() && beaten->energy >= point.energy) {
+		++beaten;
+	}
+	at = paretoFront.erase(at, beaten);
+	paretoFront.insert(at, point);
+	return 1;
+}
+
+unsigned int paretofrontsize() {
+	return paretoFront.size();
+}
+
+void printparetofront(std::ostream& out) {
+	double baselineTime = GLOB_baseline_EP_pair.second;
+	double baselineEnergy = GLOB_baseline_EP_pair.first / baselineTime;
+	for (size_t n = 0; n < paretoFront.size(); ++n) {
+		char values[96];
+		snprintf(values, sizeof(values), "%g,%g,%g,%g", paretoFront[n].time,
+				paretoFront[n].energy, paretoFront[n].time / baselineTime,
+				paretoFront[n].energy / baselineEnergy);
+		out << unpackconfiguration(paretoFront[n].id) << "," << values
+				<< std::endl;
+	}
+}
@@ -0,0 +1,470 @@
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+#include <math.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * In-process reader for sim-outorder .simout files.
+ *
+ * Replaces the grep | sed | cut pipelines that used to write
+ * summaryfiles/<file>.summary for every benchmark: the file is mapped
+ * read-only and all GLOB_fields are picked up in one pass over the
+ * statistics section. The stall counters are read the same way, on demand.
+ */
+
+static const char statsHeader[] = "sim: ** simulation statistics **";
+
+/*
+ * Bounded strtod: the mapping is not NUL-terminated, so never look past end.
+ */
+static const char* parsenumber(const char* p, const char* end, double* value) {
+	double sign = 1.0;
+	double mantissa = 0.0;
+	int digits = 0;
+	if (p < end && ('-' == *p || '+' == *p)) {
+		sign = ('-' == *p) ? -1.0 : 1.0;
+		++p;
+	}
+	while (p < end && '0' <= *p && *p <= '9') {
+		mantissa = mantissa * 10.0 + (*p++ - '0');
+		++digits;
+	}
+	if (p < end && '.' == *p) {
+		double scale = 0.1;
+		++p;
+		while (p < end && '0' <= *p && *p <= '9') {
+			mantissa += (*p++ - '0') * scale;
+			scale *= 0.1;
+			++digits;
+		}
+	}
+	if (0 == digits) {
+		return NULL;
+	}
+	if (p < end && ('e' == *p || 'E' == *p)) {
+		int expsign = 1;
+		int exponent = 0;
+		++p;
+		if (p < end && ('-' == *p || '+' == *p)) {
+			expsign = ('-' == *p) ? -1 : 1;
+			++p;
+		}
+		while (p < end && '0' <= *p && *p <= '9') {
+			exponent = exponent * 10 + (*p++ - '0');
+		}
+		mantissa *= pow(10.0, expsign * exponent);
+	}
+	*value = sign * mantissa;
+	return p;
+}
+
+static const std::string speedFields[2] = { "sim_elapsed_time ",
+		"sim_inst_rate " };
+
+/*
+ * Maps path read-only and finds its statistics section. Returns SIMOUT_OK
+ * with the mapping in begin and size, for the caller to unmap, and the
+ * section in stats; otherwise the reason, with details in error.
+ */
+static int mapstatistics(std::string path, const char** begin, size_t* size,
+		const char** stats, std::string& error) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		error = "cannot open " + path;
+		return SIMOUT_MISSING;
+	}
+	struct stat buffer;
+	if (fstat(fd, &buffer) < 0 || 0 == buffer.st_size) {
+		close(fd);
+		error = path + " is empty";
+		return SIMOUT_TRUNCATED;
+	}
+	*size = buffer.st_size;
+	void* mapping = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (MAP_FAILED == mapping) {
+		error = "cannot map " + path;
+		return SIMOUT_MISSING;
+	}
+	*begin = (const char*) mapping;
+	*stats = (const char*) memmem(*begin, *size, statsHeader,
+			sizeof(statsHeader) - 1);
+	if (!*stats) {
+		munmap(mapping, *size);
+		error = path + " has no statistics section (simulation did not finish)";
+		return SIMOUT_TRUNCATED;
+	}
+	return SIMOUT_OK;
+}
+
+int parsesimout(std::string path, double values[7], std::string& error,
+		double speed[2]) {
+	error.clear();
+	for (int j = 0; j < 7; ++j) {
+		values[j] = 0;
+	}
+	for (int k = 0; speed && k < 2; ++k) {
+		speed[k] = 0;
+	}
+
+	const char* begin;
+	size_t size;
+	const char* p;
+	int status = mapstatistics(path, &begin, &size, &p, error);
+	if (SIMOUT_OK != status) {
+		return status;
+	}
+	const char* end = begin + size;
+
+	unsigned int found = 0;
+	unsigned int divzero = 0;
+	while (p < end && found != 0x7f) {
+		const char* eol = (const char*) memchr(p, '\n', end - p);
+		if (!eol) {
+			eol = end;
+		}
+		// GLOB_fields carry their separating space, so a prefix match is exact.
+		for (int j = 0; j < 7; ++j) {
+			size_t len = GLOB_fields[j].size();
+			if ((size_t) (eol - p) > len
+					&& 0 == memcmp(p, GLOB_fields[j].data(), len)) {
+				const char* v = p + len;
+				while (v < eol && ' ' == *v) {
+					++v;
+				}
+				if (v < eol && '<' == *v) { // "<error: divide by zero>"
+					values[j] = NAN;
+					divzero |= 1 << j;
+					found |= 1 << j;
+				} else if (parsenumber(v, eol, &values[j])) {
+					found |= 1 << j;
+				}
+				break;
+			}
+		}
+		// Both come before sim_cycle, so they never prolong the pass.
+		for (int k = 0; speed && k < 2; ++k) {
+			size_t len = speedFields[k].size();
+			if ((size_t) (eol - p) > len
+					&& 0 == memcmp(p, speedFields[k].data(), len)) {
+				const char* v = p + len;
+				while (v < eol && ' ' == *v) {
+					++v;
+				}
+				parsenumber(v, eol, &speed[k]);
+			}
+		}
+		p = eol + 1;
+	}
+	munmap((void*) begin, size);
+
+	if (0x7f == found && 0 == divzero) {
+		return SIMOUT_OK;
+	}
+	error = path + ":";
+	for (int j = 0; j < 7; ++j) {
+		std::string name = GLOB_fields[j].substr(0, GLOB_fields[j].size() - 1);
+		if (!(found & (1 << j))) {
+			error += " missing " + name;
+		} else if (divzero & (1 << j)) {
+			error += " undefined " + name;
+			values[j] = 0;
+		}
+	}
+	return SIMOUT_INCOMPLETE;
+}
+
+std::string simoutpath(std::string configuration, int benchmark,
+		unsigned int fidelity) {
+	std::string dotconfig = configuration;
+	std::replace(dotconfig.begin(), dotconfig.end(), ' ', '.'); // generate filename version
+	std::string directory = GLOB_outputpath;
+	if (fidelity) { // screening runs live apart, out of importresults()' way
+		std::stringstream window;
+		window << GLOB_fidelityinsts[fidelity] << "/";
+		directory += window.str();
+	}
+	return directory + GLOB_prefixes[benchmark] + dotconfig + ".simout";
+}
+
+/*
+ * Name of a stall counter in a statistics line, NULL if it holds none. The
+ * branch predictor's counters are named after it, as in bpred_comb.misses.
+ */
+static const char* stallfield(const char* p, const char* eol, int* field) {
+	for (int k = 0; k < NUM_STALL_FIELDS; ++k) {
+		size_t len = GLOB_stallfields[k].size();
+		if (STALL_BPRED_MISSES == k) {
+			const char* name = p;
+			while (name < eol && ' ' != *name) {
+				++name;
+			}
+			if (name - p > 6 && 0 == memcmp(p, "bpred_", 6)
+					&& (size_t) (name - p) >= len
+					&& 0 == memcmp(name - len, GLOB_stallfields[k].data(), len)) {
+				*field = k;
+				return name;
+			}
+		} else if ((size_t) (eol - p) > len
+				&& 0 == memcmp(p, GLOB_stallfields[k].data(), len)) {
+			*field = k;
+			return p + len;
+		}
+	}
+	return NULL;
+}
+
+int parsestalls(std::string configuration, int benchmark,
+		double stalls[NUM_STALL_FIELDS]) {
+	const char* begin;
+	size_t size;
+	const char* p;
+	std::string error;
+	if (SIMOUT_OK
+			!= mapstatistics(simoutpath(configuration, benchmark, 0), &begin,
+					&size, &p, error)) {
+		return 0;
+	}
+	const char* end = begin + size;
+	unsigned int found = 0;
+	while (p < end && found != (1u << NUM_STALL_FIELDS) - 1) {
+		const char* eol = (const char*) memchr(p, '\n', end - p);
+		if (!eol) {
+			eol = end;
+		}
+		int field;
+		const char* v = stallfield(p, eol, &field);
+		if (v) {
+			while (v < eol && ' ' == *v) {
+				++v;
+			}
+			if (parsenumber(v, eol, &stalls[field])) {
+				found |= 1 << field;
+			}
+		}
+		p = eol + 1;
+	}
+	munmap((void*) begin, size);
+	return found == (1u << NUM_STALL_FIELDS) - 1;
+}
+
+/*
+ * Summary file left behind by the old shell pipeline: the 7 values in
+ * GLOB_fields order.
+ */
+static int parsesummary(std::string configuration, int benchmark,
+		double values[7]) {
+	std::string dotconfig = configuration;
+	std::replace(dotconfig.begin(), dotconfig.end(), ' ', '.');
+	FILE* summary = fopen(
+			("summaryfiles/" + GLOB_prefixes[benchmark] + dotconfig
+					+ ".simout.summary").c_str(), "r");
+	if (!summary) {
+		return 0;
+	}
+	int read = 0;
+	while (read < 7 && 1 == fscanf(summary, "%lf", &values[read])) {
+		++read;
+	}
+	fclose(summary);
+	return 7 == read && 0 != values[0];
+}
+
+/*
+ * Parses the requested benchmarks of a configuration; returns the mask of
+ * those that parsed cleanly.
+ */
+static unsigned int readconfiguration(std::string configuration,
+		unsigned int benchmarks, double values[5][7], std::string errors[5]) {
+	unsigned int parsed = 0;
+	for (int i = 0; i < 5; ++i) {
+		if ((benchmarks & (1 << i))
+				&& SIMOUT_OK
+						== parsesimout(simoutpath(configuration, i, 0), values[i],
+								errors[i])) {
+			parsed |= 1 << i;
+		}
+	}
+	return parsed;
+}
+
+int isconfigurationloaded(std::string configuration) {
+	ConfigMetrics* metrics = GLOB_extracted_values.find(
+			packconfiguration(configuration));
+	return metrics && 0x1f == metrics->benchmarks;
+}
+
+int collectresults(std::string configuration, int benchmark,
+		unsigned int fidelity, double speed[2]) {
+	double values[5][7];
+	std::string error;
+	int status = parsesimout(simoutpath(configuration, benchmark, fidelity),
+			values[benchmark], error, speed);
+	if (SIMOUT_OK == status) {
+		recordresults(setconfigfidelity(packconfiguration(configuration),
+				fidelity), 1 << benchmark, values);
+	} else {
+		std::cerr << error << std::endl;
+	}
+	return status;
+}
+
+int loadresults(std::string configuration) {
+	ConfigId id = packconfiguration(configuration);
+	ConfigMetrics& metrics = GLOB_extracted_values[id];
+	std::string errors[5];
+	unsigned int stored = lookupresults(id, metrics.values);
+	if (0x1f != stored) { // fall back to the raw files for what is missing
+		unsigned int parsed = readconfiguration(configuration, 0x1f & ~stored,
+				metrics.values, errors);
+		recordresults(id, parsed, metrics.values);
+		stored |= parsed;
+	}
+	int failed = 0;
+	for (int i = 0; i < 5; ++i) {
+		if (!(stored & (1 << i))) {
+			std::cerr << errors[i] << std::endl;
+			for (int j = 0; j < 7; ++j) {
+				metrics.values[i][j] = 0;
+			}
+			++failed;
+		}
+	}
+	metrics.benchmarks = stored;
+	invalidatederivedvalues(id);
+	return failed;
+}
+
+struct ImportSlice {
+	std::vector<std::string>* configurations;
+	size_t first;
+	size_t last;
+	std::vector<double>* values; // 35 per configuration
+	std::vector<unsigned int>* parsed; // in: benchmarks stored, out: parsed
+};
+
+static void* importworker(void* arg) {
+	ImportSlice* slice = (ImportSlice*) arg;
+	for (size_t c = slice->first; c < slice->last; ++c) {
+		std::string& configuration = (*slice->configurations)[c];
+		double values[5][7];
+		std::string errors[5];
+		unsigned int parsed = readconfiguration(configuration,
+				0x1f & ~(*slice->parsed)[c], values, errors);
+		(*slice->parsed)[c] = parsed;
+		std::copy(&values[0][0], &values[0][0] + 35,
+				slice->values->begin() + 35 * c);
+	}
+	return NULL;
+}
+
+/*
+ * Adds the configuration named by a "<benchmark>.<dotted configuration>"
+ * file name to configurations.
+ */
+static void addfileconfiguration(std::string name,
+		std::set<std::string>& configurations) {
+	if (name.size() < 2 + NUM_DIMS * 2 - 1 || '.' != name[1]) {
+		return;
+	}
+	std::string configuration = name.substr(2, NUM_DIMS * 2 - 1);
+	std::replace(configuration.begin(), configuration.end(), '.', ' ');
+	if (isNumDimConfiguration(configuration)) {
+		configurations.insert(configuration);
+	}
+}
+
+unsigned int importresults(unsigned int threads) {
+	std::set<std::string> found;
+	std::string directories[2] = { GLOB_outputpath, "summaryfiles/" };
+	std::string suffixes[2] = { ".simout", ".simout.summary" };
+	for (int d = 0; d < 2; ++d) {
+		DIR* dir = opendir(directories[d].c_str());
+		if (!dir) {
+			continue;
+		}
+		struct dirent* entry;
+		while ((entry = readdir(dir))) {
+			std::string name = entry->d_name;
+			if (name.size() > suffixes[d].size()
+					&& 0 == name.compare(name.size() - suffixes[d].size(),
+									suffixes[d].size(), suffixes[d])) {
+				addfileconfiguration(name, found);
+			}
+		}
+		closedir(dir);
+	}
+	std::vector<std::string> configurations;
+	for (std::set<std::string>::iterator it = found.begin(); it != found.end();
+			++it) {
+		if (!isconfigurationsimulated(packconfiguration(*it))) {
+			configurations.push_back(*it);
+		}
+	}
+
+	if (0 == threads) {
+		threads = 1;
+	}
+	if (threads > configurations.size()) {
+		threads = configurations.size();
+	}
+	std::vector<double> values(35 * configurations.size());
+	std::vector<unsigned int> parsed(configurations.size());
+	for (size_t c = 0; c < configurations.size(); ++c) {
+		// looked up here, as a lookup may remap the store under other threads
+		parsed[c] = lookupresults(packconfiguration(configurations[c]), NULL);
+	}
+	std::vector<ImportSlice> slices(threads);
+	std::vector<pthread_t> workers(threads);
+	for (unsigned int t = 0; t < threads; ++t) {
+		slices[t].configurations = &configurations;
+		slices[t].first = configurations.size() * t / threads;
+		slices[t].last = configurations.size() * (t + 1) / threads;
+		slices[t].values = &values;
+		slices[t].parsed = &parsed;
+		if (0 != pthread_create(&workers[t], NULL, importworker, &slices[t])) {
+			importworker(&slices[t]);
+			workers[t] = pthread_self();
+		}
+	}
+	for (unsigned int t = 0; t < threads; ++t) {
+		if (!pthread_equal(workers[t], pthread_self())) {
+			pthread_join(workers[t], NULL);
+		}
+	}
+
+	// The store is single-writer; append on this thread.
+	unsigned int complete = 0;
+	for (size_t c = 0; c < configurations.size(); ++c) {
+		double (*configvalues)[7] = (double (*)[7]) &values[35 * c];
+		unsigned int benchmarks = parsed[c];
+		for (int i = 0; i < 5; ++i) {
+			if (!(benchmarks & (1 << i))
+					&& parsesummary(configurations[c], i, configvalues[i])) {
+				benchmarks |= 1 << i;
+			}
+		}
+		ConfigId id = packconfiguration(configurations[c]);
+		recordresults(id, benchmarks, configvalues);
+		if (isconfigurationsimulated(id)) {
+			++complete;
+		}
+	}
+	return complete;
+}
@@ -0,0 +1,827 @@
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <vector>
+#include <stdint.h>
+#include <fcntl.h>
+
+#include "431project.h"
+
+/*
+ * Simulation job pool.
+ *
+ * Every (configuration, benchmark) pair is one job, run as its own
+ * runprojectsuite.sh process with the benchmark number as 19th argument. Up to
+ * GLOB_simulation_workers jobs are in flight at once. Each benchmark that
+ * finishes is parsed and recorded in the result store straight away, so only
+ * benchmarks missing from the store are ever queued. A configuration is
+ * complete once all of its queued benchmarks have finished.
+ *
+ * Configurations may be submitted ahead of need with a priority above 0; their
+ * jobs only start when no job of a lower priority is waiting. A configuration
+ * that is waited on is promoted to priority 0.
+ *
+ * Screening runs (fidelity above 0) are jobs of their own, pass the window as
+ * 21st argument, and count as configurations apart from the full runs.
+ *
+ * A job is claimed before it starts (see 431projectClaim.cpp) and released
+ * once its results are in the store. A job claimed by another process is held
+ * aside without taking a worker and polled every CLAIM_POLL_SECONDS: it is
+ * done once the store has its benchmark, and queued again should the other
+ * process give it up without one.
+ *
+ * Claims are taken on the simulation class of a job (see simulationclass()),
+ * and a class already running here holds back its other members, so a class
+ * is simulated once. A job whose benchmark is recorded for any member of its
+ * class copies that result instead of running.
+ *
+ * A running job is killed once it exceeds GLOB_simulation_timeout times the
+ * mean wall-clock time of jobs of the same benchmark, width and scheduling
+ * (the mean of its benchmark until SIM_SIMILAR_SAMPLES of those finished),
+ * scaled to its window and never under SIM_TIMEOUT_FLOOR seconds. The means
+ * start from the simulation times the recorded .simout files report and take
+ * in every job that finishes here; only a benchmark without any has nothing
+ * to hold a job to, and its jobs run without a limit until one finishes. A
+ * job that timed out or failed is held aside for SIM_RETRY_BACKOFF seconds,
+ * doubled per attempt, and run again with a doubled limit; after
+ * SIM_MAX_ATTEMPTS it fails and its class and benchmark are quarantined in
+ * GLOB_outputpath/quarantine, where every later submission finds them failed
+ * without a run.
+ *
+ * Every job reaped, killed ones included, adds the CPU-seconds of its script
+ * and simulator to GLOB_simulation_spent; a full-window job that succeeded
+ * also trains the cost model (see recordsimulationcost()). A killed script
+ * cannot wait for its simulator, so this process becomes the subreaper of
+ * its jobs and reaps the whole process group of a killed job itself.
+ */
+
+#define CLAIM_POLL_SECONDS 0.1
+#define SIM_TIMEOUT_FLOOR 10.0
+#define SIM_SIMILAR_SAMPLES 3
+#define SIM_MAX_ATTEMPTS 3
+#define SIM_RETRY_BACKOFF 1.0
+
+unsigned int GLOB_simulation_workers = 1;
+double GLOB_simulation_timeout = 8;
+double GLOB_simulation_spent = 0;
+
+// Mean wall-clock seconds per benchmark, used to dispatch longest jobs first.
+// Seeded with the relative mean sim_cycle of the recorded runs, which only
+// order the benchmarks, and replaced by the recorded and measured job times,
+// scaled to the full window, once there are any.
+double GLOB_benchmark_seconds[5] = { 4.1, 2.3, 1.7, 1.9, 2.4 };
+static unsigned int benchmarkSamples[5] = { 0, 0, 0, 0, 0 };
+static int secondsSeeded = 0;
+
+struct SimilarSeconds { // full-window seconds of jobs alike, see similarkey()
+	double seconds;
+	unsigned int samples;
+};
+
+struct SimJob {
+	std::string configuration;
+	int benchmark;
+	unsigned int fidelity;
+	std::string simulationclass; // claimed in place of configuration
+	unsigned int priority; // 0 for configurations being waited on
+	unsigned long sequence; // submission order, breaks ties FIFO
+	pid_t pid;
+	double started;
+	double deadline; // wall clock, 0 for none
+	unsigned int attempt; // runs that failed before this one
+	double notbefore; // wall clock a retry waits for
+};
+
+struct PendingConfig {
+	int remaining; // benchmarks queued or running
+	int failed; // benchmarks whose run returned non-zero
+	int waited; // submitted at priority 0 or waited on since
+};
+
+typedef std::pair<std::string, unsigned int> PendingKey; // with fidelity
+
+static std::vector<SimJob> queuedJobs;
+static std::vector<SimJob> heldJobs; // claimed by another process
+static std::vector<SimJob> parkedJobs; // speculative, no longer expected
+static std::map<pid_t, SimJob> runningJobs;
+static std::map<PendingKey, PendingConfig> pendingConfigs;
+static std::vector<PendingKey> finishedConfigs;
+static unsigned long jobSequence = 0;
+static unsigned long reusedBenchmarks = 0; // copied from equivalent runs
+static int benchmarkRank[5]; // dispatch order set by setbenchmarkorder()
+static int benchmarkRanked = 0;
+static std::map<int, SimilarSeconds> similarSeconds;
+static std::set<std::string> quarantined;
+static int quarantineLoaded = 0;
+static sigset_t childMask; // SIGCHLD, blocked so waits can time out
+static sigset_t savedMask; // restored in the simulators
+static int childBlocked = 0;
+
+static double wallclock() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/*
+ * CPU-seconds a reaped child and the children it waited for used.
+ */
+static double childseconds(const struct rusage& usage) {
+	return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6
+			+ usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+}
+
+static double windowshare(unsigned int fidelity) {
+	return (double) GLOB_fidelityinsts[fidelity] / GLOB_fidelityinsts[0];
+}
+
+/*
+ * Jobs alike in speed: the same benchmark on a core of the same width and
+ * scheduling, which set how many cycles the simulator steps through.
+ */
+static int similarkey(ConfigId id, int benchmark) {
+	return (benchmark * GLOB_dimensioncardinality[0] + configparam(id, 0))
+			* GLOB_dimensioncardinality[1] + configparam(id, 1);
+}
+
+static double jobtimeout(const SimJob& job) {
+	if (GLOB_simulation_timeout <= 0) {
+		return 0;
+	}
+	if (0 == benchmarkSamples[job.benchmark]) {
+		return 0; // nothing recorded or measured, the seeds are relative
+	}
+	double expected = GLOB_benchmark_seconds[job.benchmark];
+	std::map<int, SimilarSeconds>::iterator similar = similarSeconds.find(
+			similarkey(packconfiguration(job.configuration), job.benchmark));
+	if (similar != similarSeconds.end()
+			&& similar->second.samples >= SIM_SIMILAR_SAMPLES) {
+		expected = similar->second.seconds;
+	}
+	return std::max(SIM_TIMEOUT_FLOOR,
+			GLOB_simulation_timeout * expected * windowshare(job.fidelity))
+			* (1 << job.attempt);
+}
+
+/*
+ * Folds the full-window seconds of a run into the dispatch order and the time
+ * limits.
+ */
+static void addjobseconds(ConfigId id, int benchmark, double seconds) {
+	unsigned int& samples = benchmarkSamples[benchmark];
+	if (0 == samples) {
+		GLOB_benchmark_seconds[benchmark] = seconds;
+	} else {
+		GLOB_benchmark_seconds[benchmark] += (seconds
+				- GLOB_benchmark_seconds[benchmark]) / (samples + 1);
+	}
+	samples++;
+	SimilarSeconds& similar = similarSeconds[similarkey(id, benchmark)];
+	similar.samples++;
+	similar.seconds += (seconds - similar.seconds) / similar.samples;
+}
+
+static void recordjobseconds(const SimJob& job, double wall) {
+	addjobseconds(packconfiguration(job.configuration), job.benchmark,
+			wall / windowshare(job.fidelity));
+}
+
+/*
+ * Seeds the job times with the simulation times of the recorded full-window
+ * runs, taken as seedcosts() takes them.
+ */
+static void seedjobseconds() {
+	secondsSeeded = 1;
+	std::vector<std::string> names;
+	listoutputs(names);
+	for (size_t n = 0; n < names.size(); ++n) {
+		int benchmark;
+		ConfigId id;
+		double values[7];
+		double speed[2];
+		std::string error;
+		if (!traceconfiguration(names[n], ".simout", &benchmark, &id)
+				|| SIMOUT_OK
+						!= parsesimout(GLOB_outputpath + names[n], values,
+								error, speed)) {
+			continue;
+		}
+		double seconds = (speed[1] > 0) ?
+				values[FIELD_SIM_NUM_INSN] / speed[1] : speed[0];
+		if (seconds > 0) {
+			addjobseconds(id, benchmark, seconds);
+		}
+	}
+}
+
+static std::string quarantinekey(const SimJob& job) {
+	std::stringstream key;
+	key << job.benchmark << " " << job.fidelity << " " << job.simulationclass;
+	return key.str();
+}
+
+/*
+ * Whether a job is quarantined, by this process or an earlier one.
+ */
+static int isquarantined(const SimJob& job) {
+	if (!quarantineLoaded) {
+		quarantineLoaded = 1;
+		std::ifstream file((GLOB_outputpath + "quarantine").c_str());
+		std::string line;
+		while (std::getline(file, line)) {
+			quarantined.insert(line);
+		}
+	}
+	return quarantined.count(quarantinekey(job));
+}
+
+static void quarantinejob(const SimJob& job, std::string reason) {
+	std::string key = quarantinekey(job);
+	quarantined.insert(key);
+	std::ofstream file((GLOB_outputpath + "quarantine").c_str(),
+			std::ios::out | std::ios::app);
+	file << key << std::endl;
+	std::cerr << "benchmark " << job.benchmark << " of configuration "
+			<< job.configuration << " " << reason << " " << SIM_MAX_ATTEMPTS
+			<< " times, quarantined" << std::endl;
+}
+
+/*
+ * Most urgent first, then in benchmark order if one is set, else longest job
+ * first; among equals, oldest submission first.
+ */
+static bool runsBefore(const SimJob& a, const SimJob& b) {
+	if (a.priority != b.priority) {
+		return a.priority < b.priority;
+	}
+	if (benchmarkRanked
+			&& benchmarkRank[a.benchmark] != benchmarkRank[b.benchmark]) {
+		return benchmarkRank[a.benchmark] < benchmarkRank[b.benchmark];
+	}
+	double aseconds = GLOB_benchmark_seconds[a.benchmark]
+			* windowshare(a.fidelity);
+	double bseconds = GLOB_benchmark_seconds[b.benchmark]
+			* windowshare(b.fidelity);
+	if (aseconds != bseconds) {
+		return aseconds > bseconds;
+	}
+	return a.sequence < b.sequence;
+}
+
+/*
+ * Copies the result of a benchmark from an equivalent configuration, if one
+ * has it recorded; id carries the fidelity.
+ */
+static int reuseequivalent(ConfigId id, int benchmark) {
+	std::vector<ConfigId> members;
+	equivalentconfigurations(id, benchmark, members);
+	double values[5][7];
+	for (size_t m = 0; m < members.size(); ++m) {
+		if (members[m] != id
+				&& (lookupresults(members[m], values) & (1 << benchmark))) {
+			recordresults(id, 1 << benchmark, values);
+			reusedBenchmarks++;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int isbenchmarkstored(const SimJob& job) {
+	ConfigId id = setconfigfidelity(packconfiguration(job.configuration),
+			job.fidelity);
+	return 0 != (lookupresults(id, NULL) & (1 << job.benchmark))
+			|| reuseequivalent(id, job.benchmark);
+}
+
+static int isclassrunning(const SimJob& job) {
+	for (std::map<pid_t, SimJob>::iterator it = runningJobs.begin();
+			it != runningJobs.end(); ++it) {
+		if (it->second.simulationclass == job.simulationclass
+				&& it->second.benchmark == job.benchmark
+				&& it->second.fidelity == job.fidelity) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * A configuration whose benchmarks are all done waits in finishedConfigs for
+ * its waiter; a speculative one nobody waits on is forgotten, since its
+ * results are in the store and a later submission finds them there.
+ */
+static void completeconfig(const PendingKey& key) {
+	if (pendingConfigs[key].waited) {
+		finishedConfigs.push_back(key);
+	} else {
+		pendingConfigs.erase(key);
+	}
+}
+
+static void finishjob(const SimJob& job, int failed) {
+	PendingKey key(job.configuration, job.fidelity);
+	PendingConfig& pending = pendingConfigs[key];
+	if (failed) {
+		pending.failed++;
+	}
+	if (0 == --pending.remaining) {
+		completeconfig(key);
+	}
+}
+
+/*
+ * Holds a job that failed aside until its backoff expires, or fails it for
+ * good once it used up its attempts.
+ */
+static void retryjob(SimJob job, std::string reason) {
+	if (++job.attempt >= SIM_MAX_ATTEMPTS) {
+		quarantinejob(job, reason);
+		finishjob(job, 1);
+		return;
+	}
+	double backoff = SIM_RETRY_BACKOFF * (1 << (job.attempt - 1));
+	std::cerr << "benchmark " << job.benchmark << " of configuration "
+			<< job.configuration << " " << reason << ", retrying in "
+			<< backoff << " s" << std::endl;
+	job.notbefore = wallclock() + backoff;
+	heldJobs.push_back(job);
+}
+
+static void launchjob(SimJob job) {
+	std::stringstream cmdline;
+	// exec, so that the script's $$ in its part file names is the job's pid
+	cmdline << "exec " << GLOB_script << job.configuration << " "
+			<< job.benchmark;
+	if (job.fidelity) {
+		cmdline << " '' " << GLOB_fidelityinsts[job.fidelity];
+	}
+	cmdline << " > /dev/null";
+	std::string cmd = cmdline.str();
+
+	if (!childBlocked) {
+		childBlocked = 1;
+		sigemptyset(&childMask);
+		sigaddset(&childMask, SIGCHLD);
+		sigprocmask(SIG_BLOCK, &childMask, &savedMask);
+#ifdef PR_SET_CHILD_SUBREAPER
+		prctl(PR_SET_CHILD_SUBREAPER, 1); // orphaned simulators come back here
+#endif
+	}
+	fflush(stdout);
+	std::cout.flush();
+	pid_t pid = fork();
+	if (0 == pid) {
+		setpgid(0, 0); // own process group, so the whole suite can be signalled
+		sigprocmask(SIG_SETMASK, &savedMask, NULL);
+		execl("/bin/sh", "sh", "-c", cmd.c_str(), (char*) NULL);
+		_exit(127);
+	} else if (pid < 0) {
+		std::cerr << "fork failed for benchmark " << job.benchmark
+				<< " of configuration " << job.configuration << std::endl;
+		releasebenchmark(job.simulationclass, job.benchmark, job.fidelity);
+		finishjob(job, 1);
+		return;
+	}
+	setpgid(pid, pid); // also here, in case a kill comes before the child's
+	job.pid = pid;
+	job.started = wallclock();
+	double timeout = jobtimeout(job);
+	job.deadline = timeout > 0 ? job.started + timeout : 0;
+	runningJobs[pid] = job;
+}
+
+/*
+ * Starts queued jobs until all workers are busy, holding aside those another
+ * process has claimed.
+ */
+static void dispatchjobs() {
+	while (runningJobs.size() < GLOB_simulation_workers && !queuedJobs.empty()) {
+		std::vector<SimJob>::iterator next = std::min_element(
+				queuedJobs.begin(), queuedJobs.end(), runsBefore);
+		SimJob job = *next;
+		queuedJobs.erase(next);
+		if (isclassrunning(job)
+				|| !claimbenchmark(job.simulationclass, job.benchmark,
+						job.fidelity)) {
+			heldJobs.push_back(job);
+		} else if (isbenchmarkstored(job)) { // recorded by an earlier holder
+			releasebenchmark(job.simulationclass, job.benchmark, job.fidelity);
+			finishjob(job, 0);
+		} else {
+			launchjob(job);
+		}
+	}
+}
+
+/*
+ * Finishes the held jobs whose benchmark another process has recorded and
+ * queues again those it gave up, and retries whose backoff expired; returns
+ * how many moved on.
+ */
+static int pollheldjobs() {
+	int moved = 0;
+	double now = wallclock();
+	for (size_t j = heldJobs.size(); j-- > 0;) {
+		SimJob job = heldJobs[j];
+		if (isbenchmarkstored(job)) {
+			finishjob(job, 0);
+		} else if (job.notbefore > now) {
+			continue;
+		} else if (!isclassrunning(job)
+				&& !isbenchmarkclaimed(job.simulationclass, job.benchmark,
+						job.fidelity)) {
+			queuedJobs.push_back(job); // rechecked when claimed again
+		} else {
+			continue;
+		}
+		heldJobs.erase(heldJobs.begin() + j);
+		moved++;
+	}
+	return moved;
+}
+
+/*
+ * Signals the process group of a running job and reaps all of it, the
+ * simulator its script left orphaned included; returns their CPU-seconds.
+ */
+static double killjob(const SimJob& job, int signal) {
+	kill(-job.pid, signal);
+	double cpu = 0;
+	struct rusage usage;
+	while (wait4(-job.pid, NULL, 0, &usage) > 0) {
+		cpu += childseconds(usage);
+	}
+	return cpu;
+}
+
+/*
+ * Removes the part file a killed job's script left behind, see
+ * runprojectsuite.sh.
+ */
+static void removepart(const SimJob& job) {
+	char host[256] = "";
+	gethostname(host, sizeof(host) - 1);
+	std::stringstream part;
+	part << simoutpath(job.configuration, job.benchmark, job.fidelity) << "."
+			<< host << "." << job.pid << ".part";
+	unlink(part.str().c_str());
+}
+
+/*
+ * Kills the running jobs past their deadline, the simulator with its script,
+ * and retries them; returns how many.
+ */
+static int killstragglers() {
+	std::vector<pid_t> stragglers;
+	double now = wallclock();
+	for (std::map<pid_t, SimJob>::iterator it = runningJobs.begin();
+			it != runningJobs.end(); ++it) {
+		if (0 == it->second.deadline) { // maybe measured meanwhile
+			double timeout = jobtimeout(it->second);
+			it->second.deadline = timeout > 0 ? it->second.started + timeout : 0;
+		}
+		if (it->second.deadline > 0 && now >= it->second.deadline) {
+			stragglers.push_back(it->first);
+		}
+	}
+	for (size_t s = 0; s < stragglers.size(); ++s) {
+		SimJob job = runningJobs[stragglers[s]];
+		GLOB_simulation_spent += killjob(job, SIGKILL);
+		removepart(job);
+		runningJobs.erase(job.pid); // partial output is never collected
+		releasebenchmark(job.simulationclass, job.benchmark, job.fidelity);
+		double wall = now - job.started;
+		double speed[2] = { 0, 0 };
+		telemetryjob(job.configuration, job.benchmark, job.fidelity, wall,
+				JOB_TIMEDOUT, job.attempt, speed);
+		std::stringstream reason;
+		reason << "timed out after " << wall << " s";
+		retryjob(job, reason.str());
+	}
+	return stragglers.size();
+}
+
+/*
+ * Seconds until the next deadline or held job poll, -1 if there is none.
+ */
+static double nextwakeup() {
+	double wake = heldJobs.empty() ? -1 : CLAIM_POLL_SECONDS;
+	double now = wallclock();
+	for (std::map<pid_t, SimJob>::iterator it = runningJobs.begin();
+			it != runningJobs.end(); ++it) {
+		if (it->second.deadline > 0) {
+			double left = std::max(0.0, it->second.deadline - now);
+			if (wake < 0 || left < wake) {
+				wake = left;
+			}
+		}
+	}
+	return wake;
+}
+
+/*
+ * Sleeps until a child exits or the given seconds pass, -1 for no limit.
+ */
+static void waitforchild(double seconds) {
+	if (!childBlocked) {
+		usleep(seconds * 1e6); // nothing ever forked, only held jobs
+		return;
+	}
+	if (seconds < 0) {
+		int signal;
+		sigwait(&childMask, &signal);
+		return;
+	}
+	struct timespec timeout;
+	timeout.tv_sec = (time_t) seconds;
+	timeout.tv_nsec = (long) ((seconds - timeout.tv_sec) * 1e9);
+	sigtimedwait(&childMask, NULL, &timeout);
+}
+
+/*
+ * The first running job that exited, reaped, or runningJobs.end(). Only the
+ * pool's own children are waited for, so other children of the process are
+ * left to whoever started them.
+ */
+static std::map<pid_t, SimJob>::iterator reapexited(int* status,
+		struct rusage* usage) {
+	for (std::map<pid_t, SimJob>::iterator it = runningJobs.begin();
+			it != runningJobs.end(); ++it) {
+		if (wait4(it->first, status, WNOHANG, usage) > 0) {
+			return it;
+		}
+	}
+	return runningJobs.end();
+}
+
+/*
+ * Waits for one running job to exit and accounts for it, or for a held job
+ * to move on or a straggler to be killed.
+ */
+static void reapjob() {
+	int status;
+	struct rusage usage;
+	std::map<pid_t, SimJob>::iterator it;
+	for (;;) {
+		it = reapexited(&status, &usage);
+		if (it != runningJobs.end()) {
+			break;
+		}
+		if (runningJobs.empty() && heldJobs.empty()) {
+			return;
+		}
+		if (pollheldjobs() || killstragglers()) {
+			return;
+		}
+		waitforchild(nextwakeup());
+	}
+	SimJob job = it->second;
+	runningJobs.erase(it);
+
+	double wall = wallclock() - job.started;
+	double cpu = childseconds(usage);
+	GLOB_simulation_spent += cpu;
+	double speed[2] = { 0, 0 };
+	int failed = !WIFEXITED(status) || 0 != WEXITSTATUS(status)
+			|| SIMOUT_OK
+					!= collectresults(job.configuration, job.benchmark,
+							job.fidelity, speed);
+	releasebenchmark(job.simulationclass, job.benchmark, job.fidelity);
+	telemetryjob(job.configuration, job.benchmark, job.fidelity, wall,
+			failed ? JOB_FAILED : JOB_OK, job.attempt, speed);
+	if (failed) {
+		retryjob(job, "failed");
+	} else {
+		recordjobseconds(job, wall);
+		if (0 == job.fidelity) { // short windows are mostly start-up
+			recordsimulationcost(packconfiguration(job.configuration),
+					job.benchmark, cpu);
+		}
+		finishjob(job, 0);
+	}
+}
+
+void setsimulationworkers(unsigned int workers) {
+	if (0 == workers) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		workers = (cores > 0) ? cores : 1;
+	}
+	GLOB_simulation_workers = workers;
+}
+
+/*
+ * Raises the queued jobs of a configuration to at least the given priority.
+ */
+static void promotejobs(const PendingKey& key, unsigned int priority) {
+	std::map<PendingKey, PendingConfig>::iterator pending = pendingConfigs.find(
+			key);
+	if (0 == priority && pending != pendingConfigs.end()) {
+		pending->second.waited = 1;
+	}
+	for (size_t j = parkedJobs.size(); j-- > 0;) {
+		if (parkedJobs[j].configuration == key.first
+				&& parkedJobs[j].fidelity == key.second) {
+			queuedJobs.push_back(parkedJobs[j]);
+			parkedJobs.erase(parkedJobs.begin() + j);
+		}
+	}
+	for (size_t j = 0; j < queuedJobs.size(); ++j) {
+		if (queuedJobs[j].configuration == key.first
+				&& queuedJobs[j].fidelity == key.second
+				&& queuedJobs[j].priority > priority) {
+			queuedJobs[j].priority = priority;
+		}
+	}
+}
+
+int submitexperiments(std::string configuration, unsigned int priority,
+		unsigned int fidelity) {
+	if (!secondsSeeded) {
+		seedjobseconds();
+	}
+	PendingKey key(configuration, fidelity);
+	if (pendingConfigs.count(key)) {
+		promotejobs(key, priority);
+		return 1; // already queued or running
+	}
+	ConfigId id = setconfigfidelity(packconfiguration(configuration),
+			fidelity);
+	unsigned int stored = lookupresults(id, NULL);
+	for (int i = 0; i < 5; ++i) {
+		if (!(stored & (1 << i)) && reuseequivalent(id, i)) {
+			stored |= 1 << i;
+		}
+	}
+	if (0x1f == stored) {
+		return 0;
+	}
+	PendingConfig& pending = pendingConfigs[key];
+	pending.remaining = 0;
+	pending.failed = 0;
+	pending.waited = (0 == priority);
+	for (int i = 0; i < 5; ++i) {
+		if (stored & (1 << i)) {
+			continue; // recorded by an earlier, interrupted run
+		}
+		SimJob job;
+		job.configuration = configuration;
+		job.benchmark = i;
+		job.fidelity = fidelity;
+		job.simulationclass = unpackconfiguration(simulationclass(id, i));
+		job.priority = priority;
+		job.sequence = jobSequence++;
+		job.pid = 0;
+		job.started = 0;
+		job.deadline = 0;
+		job.attempt = 0;
+		job.notbefore = 0;
+		if (isquarantined(job)) {
+			pending.failed++;
+			continue;
+		}
+		pending.remaining++;
+		queuedJobs.push_back(job);
+	}
+	if (0 == pending.remaining) { // all quarantined
+		completeconfig(key);
+	}
+	dispatchjobs();
+	return 1;
+}
+
+int waitexperiments(std::string configuration, unsigned int fidelity) {
+	PendingKey key(configuration, fidelity);
+	promotejobs(key, 0);
+	while (pendingConfigs.count(key)) {
+		std::vector<PendingKey>::iterator done = std::find(
+				finishedConfigs.begin(), finishedConfigs.end(), key);
+		if (done != finishedConfigs.end()) {
+			int failed = pendingConfigs[key].failed;
+			finishedConfigs.erase(done);
+			pendingConfigs.erase(key);
+			return failed;
+		}
+		if (runningJobs.empty()) {
+			dispatchjobs();
+		}
+		reapjob();
+		dispatchjobs();
+	}
+	return 0;
+}
+
+void setbenchmarkorder(const int* order) {
+	benchmarkRanked = (NULL != order);
+	for (int k = 0; order && k < 5; ++k) {
+		benchmarkRank[order[k]] = k;
+	}
+}
+
+int stepexperiments(std::string configuration, unsigned int fidelity) {
+	PendingKey key(configuration, fidelity);
+	promotejobs(key, 0);
+	if (!pendingConfigs.count(key)) {
+		return 0;
+	}
+	std::vector<PendingKey>::iterator done = std::find(finishedConfigs.begin(),
+			finishedConfigs.end(), key);
+	if (done != finishedConfigs.end()) {
+		finishedConfigs.erase(done);
+		pendingConfigs.erase(key);
+		return 0;
+	}
+	if (runningJobs.empty()) {
+		dispatchjobs();
+	}
+	reapjob();
+	dispatchjobs();
+	return 1;
+}
+
+static void dropjobs(std::vector<SimJob>& jobs, std::string configuration,
+		unsigned int fidelity) {
+	for (size_t j = jobs.size(); j-- > 0;) {
+		if (jobs[j].configuration == configuration
+				&& jobs[j].fidelity == fidelity) {
+			jobs.erase(jobs.begin() + j);
+		}
+	}
+}
+
+void parkexperiments(std::string configuration, unsigned int fidelity) {
+	PendingKey key(configuration, fidelity);
+	std::map<PendingKey, PendingConfig>::iterator pending = pendingConfigs.find(
+			key);
+	if (pending == pendingConfigs.end() || pending->second.waited) {
+		return;
+	}
+	for (size_t j = queuedJobs.size(); j-- > 0;) {
+		if (queuedJobs[j].configuration == configuration
+				&& queuedJobs[j].fidelity == fidelity) {
+			parkedJobs.push_back(queuedJobs[j]);
+			queuedJobs.erase(queuedJobs.begin() + j);
+		}
+	}
+}
+
+void cancelexperiments(std::string configuration, unsigned int fidelity) {
+	PendingKey key(configuration, fidelity);
+	dropjobs(queuedJobs, configuration, fidelity);
+	dropjobs(heldJobs, configuration, fidelity);
+	dropjobs(parkedJobs, configuration, fidelity);
+	std::vector<pid_t> victims;
+	for (std::map<pid_t, SimJob>::iterator it = runningJobs.begin();
+			it != runningJobs.end(); ++it) {
+		if (it->second.configuration == configuration
+				&& it->second.fidelity == fidelity) {
+			victims.push_back(it->first);
+		}
+	}
+	for (size_t v = 0; v < victims.size(); ++v) {
+		// the script and its simulator
+		GLOB_simulation_spent += killjob(runningJobs[victims[v]], SIGTERM);
+		removepart(runningJobs[victims[v]]);
+		releasebenchmark(runningJobs[victims[v]].simulationclass,
+				runningJobs[victims[v]].benchmark, fidelity);
+		runningJobs.erase(victims[v]); // partial output is never collected
+	}
+	std::vector<PendingKey>::iterator done = std::find(finishedConfigs.begin(),
+			finishedConfigs.end(), key);
+	if (done != finishedConfigs.end()) {
+		finishedConfigs.erase(done);
+	}
+	pendingConfigs.erase(key);
+	dispatchjobs();
+}
+
+void drainexperiments() {
+	queuedJobs.clear(); // never started, nothing to keep
+	heldJobs.clear();
+	parkedJobs.clear();
+	while (!runningJobs.empty()) {
+		reapjob(); // records the results in the store
+	}
+	heldJobs.clear(); // retries of jobs that failed meanwhile
+	pendingConfigs.clear();
+	finishedConfigs.clear();
+}
+
+unsigned long equivalentreuses() {
+	return reusedBenchmarks;
+}
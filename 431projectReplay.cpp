@@ -0,0 +1,280 @@
+#include <iostream>
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * Simulator-free replay of a search.
+ *
+ * The proposal engine runs its usual budget, but nothing is simulated:
+ * recorded results come from the result store, and a configuration without
+ * them gets a deterministic stand-in. Each benchmark of a stand-in takes the
+ * trace-driven cache estimate when a trace of it was captured and the
+ * configuration differs from the trace in il1 dimensions only, the branch
+ * estimate when it differs in branch dimensions only, else the counters of
+ * the nearest complete recorded configuration (fewest differing independent
+ * dimensions, lowest ConfigId on ties). Stand-ins live in
+ * GLOB_extracted_values only and never reach the store.
+ */
+
+static const unsigned int replayCheckpoints[] = { 10, 20, 50, 100, 200, 500,
+		1000 };
+
+static std::vector<ConfigId> recordedIds;
+static std::vector<ConfigMetrics> recordedMetrics;
+
+static unsigned int differingdimensions(ConfigId a, ConfigId b) {
+	unsigned int differing = 0;
+	for (int d = 0; d < NUM_DIMS - NUM_DIMS_DEPENDENT; ++d) {
+		differing += (configparam(a, d) != configparam(b, d));
+	}
+	return differing;
+}
+
+/*
+ * Stand-in counters for a configuration missing from the store.
+ */
+static void standin(ConfigId id, ConfigMetrics& metrics) {
+	std::vector<ConfigMetrics> estimates, branchestimates;
+	estimatecaches(std::vector<ConfigId>(1, id), estimates);
+	estimatebranches(std::vector<ConfigId>(1, id), branchestimates);
+	size_t nearest = 0;
+	for (size_t n = 1; n < recordedIds.size(); ++n) {
+		if (differingdimensions(id, recordedIds[n])
+				< differingdimensions(id, recordedIds[nearest])) {
+			nearest = n; // recordedIds is sorted, so ties keep the lowest
+		}
+	}
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		const ConfigMetrics& source =
+				(estimates[0].benchmarks & (1 << i)) ? estimates[0] :
+				(branchestimates[0].benchmarks & (1 << i)) ?
+						branchestimates[0] : recordedMetrics[nearest];
+		std::copy(source.values[i], source.values[i] + NUM_FIELDS,
+				metrics.values[i]);
+	}
+	metrics.benchmarks = 0x1f;
+}
+
+/*
+ * Best normalised target metric after each logged proposal of the recorded
+ * run in logpath; column 0 of the log is EDP, column 1 time.
+ */
+static void recordedtrajectory(std::string logpath, int optimizeforEDP,
+		std::vector<double>& best) {
+	std::ifstream log(logpath.c_str());
+	std::string line;
+	std::getline(log, line); // the baseline
+	double running = 1.0;
+	while (std::getline(log, line)) {
+		double edp = 0, time = 0;
+		if (2 != sscanf(line.c_str(), "%lf,%lf", &edp, &time)) {
+			break;
+		}
+		running = std::min(running, optimizeforEDP ? edp : time);
+		best.push_back(running);
+	}
+}
+
+unsigned int replaysearch(std::ostream& out, ProposalEngine propose,
+		std::string engine, int optimizeforEDP, std::string logpath) {
+	std::vector<ConfigId> stored;
+	storedconfigurationids(stored);
+	std::sort(stored.begin(), stored.end());
+	ConfigMetrics metrics;
+	for (size_t n = 0; n < stored.size(); ++n) {
+		metrics.benchmarks = lookupresults(stored[n], metrics.values);
+		if (0x1f == metrics.benchmarks) {
+			recordedIds.push_back(stored[n]);
+			recordedMetrics.push_back(metrics);
+		}
+	}
+	if (recordedIds.empty()) {
+		out << "replay: no complete results to replay against" << std::endl;
+		return 0;
+	}
+	loadtraces();
+	loadbranchtraces();
+	std::vector<double> trajectory;
+	recordedtrajectory(logpath, optimizeforEDP, trajectory);
+
+	double baselineEDP = calculategeomeanEDP(GLOB_baseline);
+	double baselineTime = calculategeomeanExecutionTime(GLOB_baseline);
+	// the recorded run's best, normalised like its log
+	double target = trajectory.empty() ? 0 : 1.01 * trajectory.back();
+	std::string current = GLOB_baseline;
+	std::string bestTimeconfig = GLOB_baseline;
+	std::string bestEDPconfig = GLOB_baseline;
+	double bestEDP = baselineEDP;
+	double bestTime = baselineTime;
+	unsigned int proposals = 0;
+	unsigned int standins = 0;
+	unsigned int reached = 0; // proposals to come within 1% of the target
+	double cpu = 0;
+	size_t checkpoint = 0;
+
+	out << "Replay of the " << engine << " search for "
+			<< (optimizeforEDP ? "EDP" : "time") << std::endl
+			<< "  proposals   best EDP  best time  recorded run" << std::endl;
+	while (proposals < 1000) {
+		clock_t start = clock();
+		std::string next = propose(current, bestTimeconfig, bestEDPconfig,
+				!optimizeforEDP, optimizeforEDP);
+		cpu += (double) (clock() - start) / CLOCKS_PER_SEC;
+		if (next == current) {
+			break; // the engine has nothing left to propose
+		}
+		ConfigId id = packconfiguration(next);
+		ConfigMetrics& served = GLOB_extracted_values[id];
+		served.benchmarks = lookupresults(id, served.values);
+		if (0x1f != served.benchmarks) {
+			standin(id, served);
+			standins++;
+		}
+		invalidatederivedvalues(id);
+		markconfigurationseen(id);
+		current = next;
+		proposals++;
+
+		if (calculategeomeanEDP(id) < bestEDP) {
+			bestEDP = calculategeomeanEDP(id);
+			bestEDPconfig = next;
+		}
+		if (calculategeomeanExecutionTime(id) < bestTime) {
+			bestTime = calculategeomeanExecutionTime(id);
+			bestTimeconfig = next;
+		}
+		if (!reached
+				&& (optimizeforEDP ? bestEDP / baselineEDP :
+						bestTime / baselineTime) <= target) {
+			reached = proposals;
+		}
+		if (checkpoint < sizeof(replayCheckpoints) / sizeof(unsigned int)
+				&& proposals == replayCheckpoints[checkpoint]) {
+			char row[80];
+			snprintf(row, sizeof(row), "%11u %10.4f %10.4f", proposals,
+					bestEDP / baselineEDP, bestTime / baselineTime);
+			out << row;
+			if (proposals <= trajectory.size()) {
+				snprintf(row, sizeof(row), " %13.4f",
+						trajectory[proposals - 1]);
+				out << row;
+			}
+			out << std::endl;
+			checkpoint++;
+		}
+	}
+	if (0 == checkpoint || replayCheckpoints[checkpoint - 1] != proposals) {
+		char row[80];
+		snprintf(row, sizeof(row), "%11u %10.4f %10.4f (final)", proposals,
+				bestEDP / baselineEDP, bestTime / baselineTime);
+		out << row << std::endl;
+	}
+	out << "Recorded results served " << proposals - standins
+			<< " proposals, the stand-in " << standins << std::endl;
+	if (trajectory.empty()) {
+		out << "No recorded run in " << logpath << " to compare against"
+				<< std::endl;
+	} else if (reached) {
+		out << "Within 1% of the recorded run's best normalised "
+				<< (optimizeforEDP ? "EDP " : "time ") << target / 1.01
+				<< " after " << reached << " proposals" << std::endl;
+	} else {
+		out << "Never within 1% of the recorded run's best normalised "
+				<< (optimizeforEDP ? "EDP " : "time ") << target / 1.01
+				<< std::endl;
+	}
+	out << "Proposal engine CPU time: "
+			<< (proposals ? 1e6 * cpu / proposals : 0) << " us per proposal"
+			<< std::endl;
+	return proposals;
+}
+
+/*
+ * Evaluations after which trajectory first comes within 1% of best, 0 if
+ * never.
+ */
+static size_t evaluationsto(const std::vector<double>& trajectory,
+		double best) {
+	for (size_t n = 0; n < trajectory.size(); ++n) {
+		if (trajectory[n] <= 1.01 * best) {
+			return n + 1;
+		}
+	}
+	return 0;
+}
+
+void printsearchquality(std::ostream& out, std::string target,
+		std::string engine, int optimizeforEDP) {
+	std::string logpath = "logs/" + target + ".log";
+	std::string keptpath = "logs/" + target + "." + engine + ".log";
+	{
+		std::ifstream log(logpath.c_str());
+		std::ofstream kept(keptpath.c_str());
+		kept << log.rdbuf();
+	}
+	std::vector<double> trajectory[2]; // this search, the heuristic's
+	recordedtrajectory(logpath, optimizeforEDP, trajectory[0]);
+	int compared = ("heuristic" != engine);
+	if (compared) {
+		recordedtrajectory("logs/" + target + ".heuristic.log", optimizeforEDP,
+				trajectory[1]);
+		compared = !trajectory[1].empty();
+	}
+	if (trajectory[0].empty()) {
+		return;
+	}
+	double best = trajectory[0].back();
+	if (compared) {
+		best = std::min(best, trajectory[1].back());
+	}
+
+	char row[80];
+	out << "Search quality, best normalised " << (optimizeforEDP ? "EDP" : "time")
+			<< " after so many evaluations:" << std::endl;
+	snprintf(row, sizeof(row), "  evaluations %10s", engine.c_str());
+	out << row;
+	if (compared) {
+		snprintf(row, sizeof(row), " %10s", "heuristic");
+		out << row;
+	}
+	out << std::endl;
+	size_t longest = std::max(trajectory[0].size(), trajectory[1].size());
+	for (size_t c = 0; c < sizeof(replayCheckpoints) / sizeof(unsigned int)
+			&& replayCheckpoints[c] <= longest; ++c) {
+		unsigned int n = replayCheckpoints[c];
+		snprintf(row, sizeof(row), "%13u", n);
+		out << row;
+		for (int t = 0; t < 1 + compared; ++t) {
+			// a search that stopped early keeps its final best
+			snprintf(row, sizeof(row), " %10.4f",
+					trajectory[t][std::min((size_t) n, trajectory[t].size()) - 1]);
+			out << row;
+		}
+		out << std::endl;
+	}
+	snprintf(row, sizeof(row), "%13s", "final");
+	out << row;
+	for (int t = 0; t < 1 + compared; ++t) {
+		snprintf(row, sizeof(row), " %10.4f", trajectory[t].back());
+		out << row;
+	}
+	out << std::endl << "  evaluations to come within 1% of " << best << ":";
+	for (int t = 0; t < 1 + compared; ++t) {
+		size_t reached = evaluationsto(trajectory[t], best);
+		out << (t ? ", " : " ") << (t ? "heuristic" : engine) << " ";
+		if (reached) {
+			out << reached;
+		} else {
+			out << "never";
+		}
+	}
+	out << std::endl;
+}
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "431project.h"
+
+/*
+ * Multi-fidelity screening by successive halving.
+ *
+ * A bracket of candidates is simulated with the shortest window, and only
+ * the best 1/SCREEN_ETA of it by the geomean of the search target go on to
+ * the next longer window; the survivors of the longest screening window get
+ * the full run. Screening results live in the result store and in
+ * GLOB_extracted_values under their fidelity level, never under the full
+ * ConfigId, so only full runs can become the best configuration.
+ */
+
+double GLOB_screening_spent = 0;
+
+/*
+ * Screening counters of id (which carries its level) from the result store.
+ */
+unsigned int loadscreening(ConfigId id) {
+	ConfigMetrics& metrics = GLOB_extracted_values[id];
+	metrics.benchmarks = lookupresults(id, metrics.values);
+	invalidatederivedvalues(id);
+	return metrics.benchmarks;
+}
+
+void screenconfigurations(std::vector<std::string>& candidates,
+		int optimizeforEDP) {
+	for (int level = NUM_FIDELITIES - 1; level > 0 && candidates.size() > 1;
+			--level) {
+		// Queue the whole rung first so it runs in parallel.
+		for (size_t c = 0; c < candidates.size(); ++c) {
+			submitexperiments(candidates[c], 0, level);
+		}
+		std::vector<std::pair<double, size_t> > scores;
+		for (size_t c = 0; c < candidates.size(); ++c) {
+			waitexperiments(candidates[c], level);
+			ConfigId id = setconfigfidelity(packconfiguration(candidates[c]),
+					level);
+			if (0x1f != loadscreening(id)) {
+				std::cerr << "screening run of " << candidates[c]
+						<< " failed, dropped" << std::endl;
+				continue;
+			}
+			scores.push_back(std::make_pair(
+					optimizeforEDP ?
+							calculategeomeanEDP(id) :
+							calculategeomeanExecutionTime(id), c));
+		}
+		GLOB_screening_spent += candidates.size()
+				* (double) GLOB_fidelityinsts[level] / GLOB_fidelityinsts[0];
+
+		std::stable_sort(scores.begin(), scores.end());
+		size_t keep = (candidates.size() + SCREEN_ETA - 1) / SCREEN_ETA;
+		if (keep > scores.size()) {
+			keep = scores.size();
+		}
+		std::cout << "Screened " << candidates.size() << " at "
+				<< GLOB_fidelityinsts[level] << " instructions, keeping " << keep
+				<< std::endl;
+		std::vector<std::string> survivors;
+		for (size_t k = 0; k < keep; ++k) {
+			survivors.push_back(candidates[scores[k].second]);
+		}
+		candidates.swap(survivors);
+	}
+}
@@ -0,0 +1,276 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "431project.h"
+
+/*
+ * Design space of valid configurations.
+ *
+ * Only the cache dimensions are constrained against each other (the width
+ * rule is implied: an L1 block is never smaller than the fetch queue), so the
+ * valid space is the product of the valid cache tuples, enumerated once at
+ * startup, with the free cardinalities of the other independent dimensions.
+ * The latencies are derived from the cache geometry. A valid configuration's
+ * rank is its position in ConfigId order within that space, which makes
+ * counting, enumeration, sampling and the seen bitmap plain arithmetic.
+ */
+
+#define KILOBYTE 1024
+#define SEEN_PAGE_BITS 16 // 8 KB bitmap pages, allocated on first use
+
+static const int cacheDims[] = { 2, 3, 4, 5, 6, 7, 8, 9 };
+static const int headDims[] = { 0, 1 }; // ranked above the cache tuple
+static const int tailDims[] = { 10, 11, 12, 13, 14 }; // ranked below it
+
+static std::vector<ConfigId> validCaches; // cache fields only, sorted
+static uint64_t headCount = 1;
+static uint64_t tailCount = 1;
+static std::vector<std::vector<uint64_t> > seenPages;
+static uint64_t seenCount = 0;
+
+/*
+ * Cache constraints of validateConfiguration(), on the packed fields.
+ */
+static int isvalidcache(ConfigId id) {
+	unsigned int l1BlockSize = 8 << configparam(id, 2);
+	unsigned int ul2BlockSize = 16 << configparam(id, 8);
+	unsigned int dl1Size = getdl1size(id);
+	unsigned int il1Size = getil1size(id);
+	unsigned int ul2Size = getl2size(id);
+	return l1BlockSize >= (1u << configparam(id, 0))
+			&& ul2BlockSize >= 2 * l1BlockSize && ul2BlockSize <= 128
+			&& ul2Size >= 2 * (il1Size + dl1Size) && il1Size >= 2 * KILOBYTE
+			&& il1Size <= 64 * KILOBYTE && dl1Size >= 2 * KILOBYTE
+			&& dl1Size <= 64 * KILOBYTE && ul2Size >= 32 * KILOBYTE
+			&& ul2Size <= 1024 * KILOBYTE;
+}
+
+static int buildspace() {
+	int cacheDimCount = sizeof(cacheDims) / sizeof(cacheDims[0]);
+	std::vector<unsigned int> value(cacheDimCount, 0);
+	for (;;) {
+		ConfigId id = 0;
+		for (int c = 0; c < cacheDimCount; ++c) {
+			id = setconfigparam(id, cacheDims[c], value[c]);
+		}
+		if (isvalidcache(id)) {
+			validCaches.push_back(id);
+		}
+		int c = cacheDimCount - 1; // odometer, last dimension fastest
+		while (c >= 0 && ++value[c] == GLOB_dimensioncardinality[cacheDims[c]]) {
+			value[c--] = 0;
+		}
+		if (c < 0) {
+			break;
+		}
+	}
+	std::sort(validCaches.begin(), validCaches.end());
+	for (unsigned int h = 0; h < sizeof(headDims) / sizeof(headDims[0]); ++h) {
+		headCount *= GLOB_dimensioncardinality[headDims[h]];
+	}
+	for (unsigned int t = 0; t < sizeof(tailDims) / sizeof(tailDims[0]); ++t) {
+		tailCount *= GLOB_dimensioncardinality[tailDims[t]];
+	}
+	seenPages.resize(((headCount * validCaches.size() * tailCount)
+			>> SEEN_PAGE_BITS) + 1);
+	return 1;
+}
+static int spaceBuilt = buildspace();
+
+static ConfigId cachefields(ConfigId id) {
+	ConfigId cache = 0;
+	for (unsigned int c = 0; c < sizeof(cacheDims) / sizeof(cacheDims[0]);
+			++c) {
+		cache = setconfigparam(cache, cacheDims[c], configparam(id, cacheDims[c]));
+	}
+	return cache;
+}
+
+/*
+ * Latency index the way generateCacheLatencyParams() derives it: log2 of the
+ * size in KB plus log2 of the associativity, less the latency table offset.
+ */
+static unsigned int latencyindex(unsigned int size, unsigned int assocfield,
+		int offset, int dim) {
+	if (size < KILOBYTE) {
+		return 0; // no such cache in the valid space
+	}
+	int index = __builtin_ctz(size / KILOBYTE) + assocfield - offset;
+	return (index < 0 || index >= (int) GLOB_dimensioncardinality[dim]) ?
+			0 : index;
+}
+
+ConfigId setcachelatencies(ConfigId id) {
+	id = setconfigparam(id, 15,
+			latencyindex(getdl1size(id), configparam(id, 4), 1, 15));
+	id = setconfigparam(id, 16,
+			latencyindex(getil1size(id), configparam(id, 6), 1, 16));
+	return setconfigparam(id, 17,
+			latencyindex(getl2size(id), configparam(id, 9), 5, 17));
+}
+
+int isvalidconfiguration(ConfigId id) {
+	for (int dim = 0; dim < NUM_DIMS; ++dim) {
+		if (configparam(id, dim) >= GLOB_dimensioncardinality[dim]) {
+			return 0;
+		}
+	}
+	return isvalidcache(id);
+}
+
+uint64_t validconfigurations() {
+	return headCount * validCaches.size() * tailCount;
+}
+
+uint64_t rankconfiguration(ConfigId id) {
+	uint64_t head = 0;
+	for (unsigned int h = 0; h < sizeof(headDims) / sizeof(headDims[0]); ++h) {
+		head = head * GLOB_dimensioncardinality[headDims[h]]
+				+ configparam(id, headDims[h]);
+	}
+	uint64_t tail = 0;
+	for (unsigned int t = 0; t < sizeof(tailDims) / sizeof(tailDims[0]); ++t) {
+		tail = tail * GLOB_dimensioncardinality[tailDims[t]]
+				+ configparam(id, tailDims[t]);
+	}
+	uint64_t cache = std::lower_bound(validCaches.begin(), validCaches.end(),
+			cachefields(id)) - validCaches.begin();
+	return (head * validCaches.size() + cache) * tailCount + tail;
+}
+
+ConfigId unrankconfiguration(uint64_t rank) {
+	ConfigId id = validCaches[(rank / tailCount) % validCaches.size()];
+	uint64_t tail = rank % tailCount;
+	for (int t = sizeof(tailDims) / sizeof(tailDims[0]) - 1; t >= 0; --t) {
+		id = setconfigparam(id, tailDims[t],
+				tail % GLOB_dimensioncardinality[tailDims[t]]);
+		tail /= GLOB_dimensioncardinality[tailDims[t]];
+	}
+	uint64_t head = rank / tailCount / validCaches.size();
+	for (int h = sizeof(headDims) / sizeof(headDims[0]) - 1; h >= 0; --h) {
+		id = setconfigparam(id, headDims[h],
+				head % GLOB_dimensioncardinality[headDims[h]]);
+		head /= GLOB_dimensioncardinality[headDims[h]];
+	}
+	return setcachelatencies(id);
+}
+
+ConfigId sampleconfiguration() {
+	uint64_t r = ((uint64_t) rand() << 31) ^ (uint64_t) rand();
+	return unrankconfiguration(r % validconfigurations());
+}
+
+void validneighbours(ConfigId id, std::vector<ConfigId>& neighbours) {
+	for (int dim = 0; dim < NUM_DIMS - NUM_DIMS_DEPENDENT; ++dim) {
+		for (unsigned int value = 0; value < GLOB_dimensioncardinality[dim];
+				++value) {
+			if (value == configparam(id, dim)) {
+				continue;
+			}
+			ConfigId neighbour = setcachelatencies(
+					setconfigparam(id, dim, value));
+			if (isvalidcache(neighbour)) {
+				neighbours.push_back(neighbour);
+			}
+		}
+	}
+}
+
+/*
+ * Simulation equivalence. The dimensions below only reach sim-outorder in ways
+ * some configurations cannot tell apart:
+ *
+ *   replacepolicy   with every cache direct-mapped there is no victim to pick
+ *                   (the TLBs keep the simulator's default policy)
+ *   ras, btb        the nottaken predictor allocates neither
+ *   fpwidth         bzip2, mcf and sjeng issue no floating point in their
+ *                   window; hmmer and equake do
+ *
+ * The recorded runs agree: configurations differing only in fpwidth have
+ * identical counters for those three benchmarks and not for hmmer.
+ */
+static const unsigned int fpfreeBenchmarks = 0x0b;
+
+/*
+ * Mask of the dimensions (bit 1 << dim) the simulation of a benchmark
+ * ignores in a configuration.
+ */
+static unsigned int ignoreddimensions(ConfigId id, int benchmark) {
+	unsigned int ignored = 0;
+	if (0 == configparam(id, 4) && 0 == configparam(id, 6)
+			&& 0 == configparam(id, 9)) {
+		ignored |= 1 << 10;
+	}
+	if (0 == configparam(id, 12)) {
+		ignored |= (1 << 13) | (1 << 14);
+	}
+	if (fpfreeBenchmarks & (1 << benchmark)) {
+		ignored |= 1 << 11;
+	}
+	return ignored;
+}
+
+ConfigId simulationclass(ConfigId id, int benchmark) {
+	unsigned int ignored = ignoreddimensions(id, benchmark);
+	for (int dim = 0; dim < NUM_DIMS; ++dim) {
+		if (ignored & (1 << dim)) {
+			id = setconfigparam(id, dim, 0);
+		}
+	}
+	return id;
+}
+
+void equivalentconfigurations(ConfigId id, int benchmark,
+		std::vector<ConfigId>& members) {
+	unsigned int ignored = ignoreddimensions(id, benchmark);
+	size_t first = members.size();
+	members.push_back(simulationclass(id, benchmark));
+	for (int dim = 0; dim < NUM_DIMS; ++dim) {
+		if (!(ignored & (1 << dim))) {
+			continue;
+		}
+		size_t count = members.size();
+		for (unsigned int value = 1; value < GLOB_dimensioncardinality[dim];
+				++value) {
+			for (size_t m = first; m < count; ++m) {
+				members.push_back(setconfigparam(members[m], dim, value));
+			}
+		}
+	}
+}
+
+void markconfigurationseen(ConfigId id) {
+	if (!isvalidconfiguration(id)) {
+		return; // outside the space, never proposed
+	}
+	uint64_t rank = rankconfiguration(id);
+	std::vector<uint64_t>& page = seenPages[rank >> SEEN_PAGE_BITS];
+	if (page.empty()) {
+		page.resize((1 << SEEN_PAGE_BITS) / 64, 0);
+	}
+	uint64_t bit = rank & ((1 << SEEN_PAGE_BITS) - 1);
+	if (!(page[bit / 64] & (1ULL << (bit % 64)))) {
+		page[bit / 64] |= 1ULL << (bit % 64);
+		++seenCount;
+	}
+}
+
+int isconfigurationseen(ConfigId id) {
+	if (!isvalidconfiguration(id)) {
+		return 0;
+	}
+	uint64_t rank = rankconfiguration(id);
+	const std::vector<uint64_t>& page = seenPages[rank >> SEEN_PAGE_BITS];
+	uint64_t bit = rank & ((1 << SEEN_PAGE_BITS) - 1);
+	return !page.empty() && (page[bit / 64] >> (bit % 64)) & 1;
+}
+
+uint64_t seenconfigurations() {
+	return seenCount;
+}
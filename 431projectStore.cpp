@@ -0,0 +1,397 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <map>
+#include <vector>
+
+#include "431project.h"
+
+/*
+ * Single-file result store.
+ *
+ * Layout: a header, then a log of fixed-size records and hash indexes in the
+ * order they were appended. A record holds the GLOB_fields values of every
+ * benchmark recorded so far for one configuration. Records are never
+ * rewritten: adding a benchmark appends a new version of the record and
+ * repoints its index slot. When the index passes half full a twice larger
+ * one is appended and the header switched over to it, so the file only ever
+ * grows. The whole file is mapped shared; lookups touch no other file.
+ *
+ * Screening results are records of their own, told apart by their fidelity
+ * level; full results have level 0, as every record written before levels
+ * existed, and hash as they always did.
+ *
+ * Any number of processes, on any hosts sharing the directory, may use the
+ * store at once. Every access holds an fcntl() lock on the whole file, shared
+ * for lookups and exclusive for appends. NFS clients honour such locks across
+ * hosts, write back on unlock, and drop cached pages on the next read after
+ * locking, which is what the pread() of the header in lockstore() is for.
+ * The header also tells whether another process appended past the mapping,
+ * a new index or records; only then is the file measured and mapped again.
+ */
+
+#define STORE_VERSION 1
+#define STORE_MIN_SLOTS 1024
+
+static const char storeMagic[8] = { 'D', 'S', 'E', 'S', 'T', 'O', 'R', 'E' };
+
+struct StoreHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t recordsize;
+	uint64_t records; // live configurations
+	uint64_t used; // bytes of the file in use
+	uint64_t indexoffset;
+	uint64_t indexslots; // power of two; slot value 0 means empty
+};
+
+struct StoreRecord {
+	unsigned char configuration[NUM_DIMS];
+	unsigned char completed; // bit i set: benchmark i recorded
+	unsigned char fidelity;
+	unsigned char reserved[4];
+	double values[5][7];
+};
+
+static int storefd = -1;
+static char* storebase = NULL;
+static size_t storemapped = 0;
+
+static StoreHeader* storeheader() {
+	return (StoreHeader*) storebase;
+}
+
+static uint64_t* storeindex() {
+	return (uint64_t*) (storebase + storeheader()->indexoffset);
+}
+
+static StoreRecord* storerecord(uint64_t offset) {
+	return (StoreRecord*) (storebase + offset);
+}
+
+static void packkey(ConfigId id, unsigned char key[NUM_DIMS]) {
+	for (int dim = 0; dim < NUM_DIMS; ++dim) {
+		key[dim] = configparam(id, dim);
+	}
+}
+
+static uint64_t hashkey(const unsigned char key[NUM_DIMS],
+		unsigned int fidelity) {
+	uint64_t hash = 14695981039346656037ULL; // FNV-1a
+	for (int dim = 0; dim < NUM_DIMS; ++dim) {
+		hash = (hash ^ key[dim]) * 1099511628211ULL;
+	}
+	if (fidelity) {
+		hash = (hash ^ (0x100 | fidelity)) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+/*
+ * Replaces the mapping with one of the given size.
+ */
+static int mapstore(size_t size) {
+	void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			storefd, 0);
+	if (MAP_FAILED == mapping) {
+		std::cerr << "result store: cannot map " << size << " bytes"
+				<< std::endl;
+		return -1;
+	}
+	if (storebase) {
+		munmap(storebase, storemapped);
+	}
+	storebase = (char*) mapping;
+	storemapped = size;
+	return 0;
+}
+
+/*
+ * Maps the whole file, as another process may have grown it.
+ */
+static int remapstore() {
+	struct stat buffer;
+	if (0 != fstat(storefd, &buffer)) {
+		return -1;
+	}
+	return ((size_t) buffer.st_size > storemapped) ?
+			mapstore(buffer.st_size) : 0;
+}
+
+/*
+ * Takes (F_RDLCK, F_WRLCK) or drops (F_UNLCK) the lock on the store. Once
+ * locked, the mapping spans every byte the header counts as used.
+ */
+static int lockstore(short type) {
+	struct flock lock;
+	memset(&lock, 0, sizeof(lock));
+	lock.l_type = type;
+	lock.l_whence = SEEK_SET; // l_start = l_len = 0: the whole file
+	while (0 != fcntl(storefd, F_SETLKW, &lock)) {
+		if (EINTR != errno) {
+			std::cerr << "result store: cannot lock" << std::endl;
+			return -1;
+		}
+	}
+	if (F_UNLCK == type) {
+		return 0;
+	}
+	StoreHeader header;
+	ssize_t got = pread(storefd, &header, sizeof(header), 0);
+	if (got < 0 || ((got < (ssize_t) sizeof(header) // not initialised yet
+			|| header.used > storemapped) && 0 != remapstore())) {
+		lockstore(F_UNLCK);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Makes room for bytes more past header->used, growing the file if needed.
+ * Called with the store locked for writing.
+ */
+static int reservestore(size_t bytes) {
+	size_t needed = storeheader()->used + bytes;
+	if (needed <= storemapped) {
+		return 0;
+	}
+	if (0 != remapstore()) { // the file may be larger than the mapping
+		return -1;
+	}
+	if (needed <= storemapped) {
+		return 0;
+	}
+	size_t capacity = storemapped * 2;
+	if (capacity < needed) {
+		capacity = needed;
+	}
+	if (0 != ftruncate(storefd, capacity)) {
+		std::cerr << "result store: cannot grow to " << capacity << " bytes"
+				<< std::endl;
+		return -1;
+	}
+	return mapstore(capacity);
+}
+
+/*
+ * Slot holding key at the given fidelity, or the empty slot where it would go.
+ */
+static uint64_t findslot(const unsigned char key[NUM_DIMS],
+		unsigned int fidelity) {
+	uint64_t mask = storeheader()->indexslots - 1;
+	uint64_t slot = hashkey(key, fidelity) & mask;
+	uint64_t* index = storeindex();
+	while (index[slot]
+			&& (0 != memcmp(storerecord(index[slot])->configuration, key,
+					NUM_DIMS) || fidelity != storerecord(index[slot])->fidelity)) {
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+/*
+ * Appends a zeroed index of the given size and rehashes the live records.
+ */
+static int appendindex(uint64_t slots) {
+	if (0 != reservestore(slots * sizeof(uint64_t))) {
+		return -1;
+	}
+	StoreHeader* header = storeheader();
+	uint64_t oldoffset = header->indexoffset;
+	uint64_t oldslots = header->indexslots;
+	uint64_t newoffset = header->used;
+	memset(storebase + newoffset, 0, slots * sizeof(uint64_t));
+
+	uint64_t* newindex = (uint64_t*) (storebase + newoffset);
+	for (uint64_t s = 0; oldoffset && s < oldslots; ++s) {
+		uint64_t offset = ((uint64_t*) (storebase + oldoffset))[s];
+		if (offset) {
+			uint64_t slot = hashkey(storerecord(offset)->configuration,
+					storerecord(offset)->fidelity) & (slots - 1);
+			while (newindex[slot]) {
+				slot = (slot + 1) & (slots - 1);
+			}
+			newindex[slot] = offset;
+		}
+	}
+	header->used = newoffset + slots * sizeof(uint64_t);
+	header->indexslots = slots;
+	header->indexoffset = newoffset; // switch over last
+	return 0;
+}
+
+/*
+ * Initialises a fresh store, or checks an existing one; called locked.
+ */
+static int initresultstore(std::string path) {
+	if (0 == storemapped) { // empty: no other process got here first
+		if (0 != ftruncate(storefd, sizeof(StoreHeader))
+				|| 0 != mapstore(sizeof(StoreHeader))) {
+			std::cerr << "result store: cannot initialise " << path
+					<< std::endl;
+			return -1;
+		}
+		StoreHeader* header = storeheader();
+		memcpy(header->magic, storeMagic, sizeof(storeMagic));
+		header->version = STORE_VERSION;
+		header->recordsize = sizeof(StoreRecord);
+		header->records = 0;
+		header->used = sizeof(StoreHeader);
+		header->indexoffset = 0;
+		header->indexslots = 0;
+		return appendindex(STORE_MIN_SLOTS);
+	}
+	StoreHeader* header = storeheader();
+	if (storemapped < sizeof(StoreHeader)
+			|| 0 != memcmp(header->magic, storeMagic, sizeof(storeMagic))
+			|| STORE_VERSION != header->version
+			|| sizeof(StoreRecord) != header->recordsize
+			|| header->used > storemapped) {
+		std::cerr << "result store: " << path
+				<< " is not a result store of this version" << std::endl;
+		return -1;
+	}
+	return 0;
+}
+
+int openresultstore(std::string path) {
+	storefd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if (storefd < 0) {
+		std::cerr << "result store: cannot open " << path << std::endl;
+		return -1;
+	}
+	if (0 != lockstore(F_WRLCK)) {
+		return -1;
+	}
+	int status = initresultstore(path);
+	lockstore(F_UNLCK);
+	if (0 != status && storebase) {
+		munmap(storebase, storemapped);
+		storebase = NULL;
+		storemapped = 0;
+	}
+	return status;
+}
+
+unsigned int storedconfigurations() {
+	if (!storebase || 0 != lockstore(F_RDLCK)) {
+		return 0;
+	}
+	unsigned int records = 0;
+	uint64_t* index = storeindex();
+	for (uint64_t slot = 0; slot < storeheader()->indexslots; ++slot) {
+		records += index[slot] && 0 == storerecord(index[slot])->fidelity;
+	}
+	lockstore(F_UNLCK);
+	return records;
+}
+
+void storedconfigurationids(std::vector<ConfigId>& ids) {
+	if (!storebase || 0 != lockstore(F_RDLCK)) {
+		return;
+	}
+	uint64_t* index = storeindex();
+	for (uint64_t slot = 0; slot < storeheader()->indexslots; ++slot) {
+		if (index[slot] && 0 == storerecord(index[slot])->fidelity) {
+			ConfigId id = 0;
+			for (int dim = 0; dim < NUM_DIMS; ++dim) {
+				id = setconfigparam(id, dim,
+						storerecord(index[slot])->configuration[dim]);
+			}
+			ids.push_back(id);
+		}
+	}
+	lockstore(F_UNLCK);
+}
+
+unsigned int lookupresults(ConfigId id, double values[5][7]) {
+	if (!storebase || 0 != lockstore(F_RDLCK)) {
+		return 0;
+	}
+	unsigned char key[NUM_DIMS];
+	packkey(id, key);
+	uint64_t offset = storeindex()[findslot(key, configfidelity(id))];
+	unsigned int completed = 0;
+	if (offset) {
+		StoreRecord* record = storerecord(offset);
+		if (values) {
+			memcpy(values, record->values, sizeof(record->values));
+		}
+		completed = record->completed;
+	}
+	lockstore(F_UNLCK);
+	return completed;
+}
+
+int isconfigurationsimulated(ConfigId id) {
+	return 0x1f == lookupresults(id, NULL);
+}
+
+/*
+ * Appends a new version of the record of id; called locked for writing.
+ */
+static int appendresults(ConfigId id, unsigned int benchmarks,
+		double values[5][7]) {
+	if (0 != reservestore(sizeof(StoreRecord))) {
+		return -1;
+	}
+	unsigned char key[NUM_DIMS];
+	packkey(id, key);
+	uint64_t slot = findslot(key, configfidelity(id));
+	uint64_t previous = storeindex()[slot];
+
+	StoreHeader* header = storeheader();
+	uint64_t offset = header->used;
+	StoreRecord* record = storerecord(offset);
+	if (previous) {
+		memcpy(record, storerecord(previous), sizeof(StoreRecord));
+	} else {
+		memset(record, 0, sizeof(StoreRecord));
+		memcpy(record->configuration, key, NUM_DIMS);
+		record->fidelity = configfidelity(id);
+	}
+	for (int i = 0; i < 5; ++i) {
+		if (benchmarks & (1 << i)) {
+			memcpy(record->values[i], values[i], sizeof(record->values[i]));
+		}
+	}
+	record->completed |= benchmarks;
+	header->used += sizeof(StoreRecord);
+
+	// Publish: the record is complete before any index points at it.
+	storeindex()[slot] = offset;
+	if (!previous && 2 * ++header->records > header->indexslots) {
+		return appendindex(2 * header->indexslots);
+	}
+	return 0;
+}
+
+int recordresults(ConfigId id, unsigned int benchmarks, double values[5][7]) {
+	if (!storebase || 0 == benchmarks || 0 != lockstore(F_WRLCK)) {
+		return -1;
+	}
+	int status = appendresults(id, benchmarks, values);
+	lockstore(F_UNLCK);
+	return status;
+}
+
+void closeresultstore() {
+	if (storebase) {
+		msync(storebase, storemapped, MS_SYNC);
+		munmap(storebase, storemapped);
+		storebase = NULL;
+		storemapped = 0;
+	}
+	if (storefd >= 0) {
+		close(storefd);
+		storefd = -1;
+	}
+}
@@ -0,0 +1,411 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+#include <math.h>
+
+#include "431project.h"
+
+/*
+ * Surrogate-guided search.
+ *
+ * A Bayesian linear regression predicts log(1 + counter) for every benchmark
+ * and GLOB_fields counter from a one-hot encoding of the independent
+ * dimensions plus the log2 cache sizes. All 35 targets share one design
+ * matrix, so one Cholesky factor of the posterior precision serves them all;
+ * each target keeps its own residual variance. Predicted counters go through
+ * the energy/time model unchanged, and candidates are ranked by the lower
+ * confidence bound of log geomean EDP or time: the prediction less
+ * SURROGATE_EXPLORATION standard deviations. Configurations already in
+ * GLOB_extracted_values score with their real counters and no uncertainty.
+ *
+ * A budgeted search (-budget, -deadline) ranks candidates instead by their
+ * expected improvement on the log objective of the best known configuration
+ * per predicted CPU-second of simulation (predictsimulationseconds()), so
+ * a cheap candidate may go before a slightly more promising, costly one.
+ */
+
+#define SURROGATE_PRIOR 10.0 // prior precision of every non-intercept weight
+#define SURROGATE_EXPLORATION 0.5 // standard deviations of optimism
+#define SURROGATE_SAMPLES 1024 // uniform candidates per proposal
+#define SURROGATE_PARENTS 4 // best known configurations whose neighbours compete
+#define SURROGATE_MIN_SECONDS 0.1 // cost of a proposal with every result on record
+
+static const int surrogateFeatures = 1 + (4 - 1) + (2 - 1) + (4 - 1) + (9 - 1)
+		+ (3 - 1) + (9 - 1) + (3 - 1) + (10 - 1) + (4 - 1) + (5 - 1) + (3 - 1)
+		+ (4 - 1) + (5 - 1) + (4 - 1) + (5 - 1) + 3;
+
+struct SurrogateModel {
+	unsigned int samples;
+	std::vector<double> factor; // lower Cholesky factor of the precision
+	std::vector<double> weights; // surrogateFeatures per target
+	double noise[NUM_BENCHMARKS][NUM_FIELDS]; // residual variance
+};
+
+/*
+ * Intercept, one-hot of every independent dimension (value 0 is the
+ * reference), then log2 of the dl1, il1 and ul2 sizes in KB.
+ */
+static void surrogatefeatures(ConfigId id, double features[]) {
+	int f = 0;
+	features[f++] = 1.0;
+	for (int dim = 0; dim < NUM_DIMS - NUM_DIMS_DEPENDENT; ++dim) {
+		for (unsigned int value = 1; value < GLOB_dimensioncardinality[dim];
+				++value) {
+			features[f++] = (value == configparam(id, dim)) ? 1.0 : 0.0;
+		}
+	}
+	features[f++] = __builtin_ctz(getdl1size(id)) - 10;
+	features[f++] = __builtin_ctz(getil1size(id)) - 10;
+	features[f++] = __builtin_ctz(getl2size(id)) - 10;
+}
+
+/*
+ * Solves L z = b in place.
+ */
+static void forwardsolve(const std::vector<double>& factor, double b[]) {
+	for (int r = 0; r < surrogateFeatures; ++r) {
+		for (int c = 0; c < r; ++c) {
+			b[r] -= factor[r * surrogateFeatures + c] * b[c];
+		}
+		b[r] /= factor[r * surrogateFeatures + r];
+	}
+}
+
+/*
+ * Solves L^T x = z in place.
+ */
+static void backsolve(const std::vector<double>& factor, double z[]) {
+	for (int r = surrogateFeatures - 1; r >= 0; --r) {
+		for (int c = r + 1; c < surrogateFeatures; ++c) {
+			z[r] -= factor[c * surrogateFeatures + r] * z[c];
+		}
+		z[r] /= factor[r * surrogateFeatures + r];
+	}
+}
+
+/*
+ * Fits the model to the counters of the given configurations, which must be
+ * complete in GLOB_extracted_values.
+ */
+static void fitsurrogate(const std::vector<ConfigId>& ids,
+		SurrogateModel& model) {
+	const int p = surrogateFeatures;
+	const int targets = NUM_BENCHMARKS * NUM_FIELDS;
+	std::vector<double> precision(p * p, 0.0);
+	std::vector<double> projection(p * targets, 0.0); // X^T y per target
+	std::vector<double> features(p);
+	for (size_t n = 0; n < ids.size(); ++n) {
+		const ConfigMetrics& metrics = *GLOB_extracted_values.find(ids[n]);
+		surrogatefeatures(ids[n], &features[0]);
+		for (int r = 0; r < p; ++r) {
+			for (int c = 0; c <= r; ++c) {
+				precision[r * p + c] += features[r] * features[c];
+			}
+			for (int t = 0; t < targets; ++t) {
+				projection[t * p + r] += features[r]
+						* log1p(metrics.values[t / NUM_FIELDS][t % NUM_FIELDS]);
+			}
+		}
+	}
+	for (int r = 0; r < p; ++r) {
+		precision[r * p + r] += (0 == r) ? 1e-9 : SURROGATE_PRIOR;
+	}
+
+	// Cholesky, lower triangle.
+	model.factor.assign(p * p, 0.0);
+	for (int r = 0; r < p; ++r) {
+		for (int c = 0; c <= r; ++c) {
+			double sum = precision[r * p + c];
+			for (int k = 0; k < c; ++k) {
+				sum -= model.factor[r * p + k] * model.factor[c * p + k];
+			}
+			model.factor[r * p + c] =
+					(r == c) ? sqrt(sum) : sum / model.factor[c * p + c];
+		}
+	}
+	model.weights = projection;
+	for (int t = 0; t < targets; ++t) {
+		forwardsolve(model.factor, &model.weights[t * p]);
+		backsolve(model.factor, &model.weights[t * p]);
+	}
+
+	double residuals[NUM_BENCHMARKS][NUM_FIELDS] = { { 0 } };
+	for (size_t n = 0; n < ids.size(); ++n) {
+		const ConfigMetrics& metrics = *GLOB_extracted_values.find(ids[n]);
+		surrogatefeatures(ids[n], &features[0]);
+		for (int t = 0; t < targets; ++t) {
+			double predicted = 0.0;
+			for (int f = 0; f < p; ++f) {
+				predicted += features[f] * model.weights[t * p + f];
+			}
+			double error = log1p(metrics.values[t / NUM_FIELDS][t % NUM_FIELDS])
+					- predicted;
+			residuals[t / NUM_FIELDS][t % NUM_FIELDS] += error * error;
+		}
+	}
+	model.samples = ids.size();
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		for (int j = 0; j < NUM_FIELDS; ++j) {
+			// With few samples the fit is exact; fall back to a broad prior.
+			model.noise[i][j] = (ids.size() > 1) ?
+					residuals[i][j] / (ids.size() - 1) + 1e-4 : 1.0;
+		}
+	}
+}
+
+/*
+ * Predicted counters of a configuration, and the predictive variance of
+ * log(1 + sim_cycle) for each benchmark.
+ */
+static void predictsurrogate(const SurrogateModel& model, ConfigId id,
+		ConfigMetrics& predicted, double cyclevariance[NUM_BENCHMARKS]) {
+	const int p = surrogateFeatures;
+	double features[surrogateFeatures];
+	double leverage[surrogateFeatures];
+	surrogatefeatures(id, features);
+	std::copy(features, features + p, leverage);
+	forwardsolve(model.factor, leverage);
+	double h = 0.0;
+	for (int f = 0; f < p; ++f) {
+		h += leverage[f] * leverage[f];
+	}
+	for (int t = 0; t < NUM_BENCHMARKS * NUM_FIELDS; ++t) {
+		double mean = 0.0;
+		for (int f = 0; f < p; ++f) {
+			mean += features[f] * model.weights[t * p + f];
+		}
+		predicted.values[t / NUM_FIELDS][t % NUM_FIELDS] = expm1(mean);
+	}
+	predicted.benchmarks = 0x1f;
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		cyclevariance[i] = model.noise[i][FIELD_SIM_CYCLE] * (1.0 + h);
+	}
+}
+
+struct ScoredCandidate {
+	double score;
+	ConfigId id;
+	bool operator<(const ScoredCandidate& other) const {
+		return score < other.score || (score == other.score && id < other.id);
+	}
+};
+
+/*
+ * Expected amount by which a normal log objective falls below best.
+ */
+static double expectedimprovement(double mean, double deviation, double best) {
+	if (deviation <= 0) {
+		return std::max(0.0, best - mean);
+	}
+	double z = (best - mean) / deviation;
+	return (best - mean) * 0.5 * erfc(-z / sqrt(2.0))
+			+ deviation * exp(-0.5 * z * z) / sqrt(2.0 * M_PI);
+}
+
+/*
+ * Scores candidates by the lower confidence bound of the log objective, or,
+ * given the log objective of the best known configuration as incumbent, by
+ * the expected improvement on it per predicted second; best first. known:
+ * candidates with real counters in GLOB_extracted_values.
+ */
+static void scorecandidates(const SurrogateModel& model,
+		const std::vector<ConfigId>& candidates, const std::set<ConfigId>& known,
+		int optimizeforEDP, std::vector<ScoredCandidate>& scored,
+		double incumbent = HUGE_VAL) {
+	EvaluationBatch batch;
+	std::vector<double> deviation(candidates.size());
+	for (size_t n = 0; n < candidates.size(); ++n) {
+		if (known.count(candidates[n])) {
+			batch.add(candidates[n], *GLOB_extracted_values.find(candidates[n]));
+			deviation[n] = 0.0;
+			continue;
+		}
+		ConfigMetrics predicted;
+		double cyclevariance[NUM_BENCHMARKS];
+		predictsurrogate(model, candidates[n], predicted, cyclevariance);
+		batch.add(candidates[n], predicted);
+		// Time follows sim_cycle and EDP its square; the geomean averages
+		// the five benchmarks, taken as independent.
+		double variance = 0.0;
+		for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+			variance += cyclevariance[i];
+		}
+		deviation[n] = (optimizeforEDP ? 2.0 : 1.0) * sqrt(variance)
+				/ NUM_BENCHMARKS;
+	}
+	evaluatebatch(batch, 0);
+	scored.resize(candidates.size());
+	for (size_t n = 0; n < candidates.size(); ++n) {
+		scored[n].id = candidates[n];
+		double mean = log(
+				optimizeforEDP ? batch.geomeanEDP[n] : batch.geomeanTime[n]);
+		if (incumbent < HUGE_VAL) {
+			scored[n].score = -expectedimprovement(mean, deviation[n], incumbent)
+					/ std::max(SURROGATE_MIN_SECONDS,
+							predictsimulationseconds(candidates[n]));
+		} else {
+			scored[n].score = mean - SURROGATE_EXPLORATION * deviation[n];
+		}
+	}
+	std::sort(scored.begin(), scored.end());
+}
+
+/*
+ * Complete configurations in GLOB_extracted_values.
+ */
+static void completeconfigurations(std::vector<ConfigId>& ids) {
+	for (size_t slot = 0; slot < GLOB_extracted_values.keys.size(); ++slot) {
+		if (NO_CONFIG != GLOB_extracted_values.keys[slot]
+				&& 0x1f == GLOB_extracted_values.values[slot].benchmarks) {
+			ids.push_back(GLOB_extracted_values.keys[slot]);
+		}
+	}
+	std::sort(ids.begin(), ids.end());
+}
+
+/*
+ * Unseen candidates ranked best first, skipping those in exclude.
+ */
+static void rankproposals(std::string bestEXECconfiguration,
+		std::string bestEDPconfiguration, int optimizeforEDP,
+		const std::set<ConfigId>& exclude,
+		std::vector<ScoredCandidate>& scored) {
+	static int historyLoaded = 0;
+	if (!historyLoaded) { // train on every earlier result, not just this run's
+		std::vector<ConfigId> stored;
+		storedconfigurationids(stored);
+		for (size_t n = 0; n < stored.size(); ++n) {
+			if (isconfigurationsimulated(stored[n])
+					&& !isconfigurationloaded(unpackconfiguration(stored[n]))) {
+				loadresults(unpackconfiguration(stored[n]));
+			}
+		}
+		historyLoaded = 1;
+	}
+	std::vector<ConfigId> training;
+	completeconfigurations(training);
+	SurrogateModel model;
+	fitsurrogate(training, model);
+	std::set<ConfigId> known(training.begin(), training.end());
+
+	// Parents: the best known configurations, whose neighbours are the most
+	// likely improvements.
+	std::vector<ScoredCandidate> parents;
+	scorecandidates(model, training, known, optimizeforEDP, parents);
+	std::set<ConfigId> candidates;
+	candidates.insert(packconfiguration(
+			optimizeforEDP ? bestEDPconfiguration : bestEXECconfiguration));
+	for (size_t n = 0; n < parents.size() && n < SURROGATE_PARENTS; ++n) {
+		candidates.insert(parents[n].id);
+	}
+	std::vector<ConfigId> neighbours;
+	for (std::set<ConfigId>::iterator it = candidates.begin();
+			it != candidates.end(); ++it) {
+		validneighbours(*it, neighbours);
+	}
+	candidates.insert(neighbours.begin(), neighbours.end());
+	for (int s = 0; s < SURROGATE_SAMPLES; ++s) {
+		candidates.insert(sampleconfiguration());
+	}
+
+	std::vector<ConfigId> unseen;
+	for (std::set<ConfigId>::iterator it = candidates.begin();
+			it != candidates.end(); ++it) {
+		if (isvalidconfiguration(*it) && !isconfigurationseen(*it)
+				&& !exclude.count(*it)) {
+			unseen.push_back(*it);
+		}
+	}
+	double incumbent = HUGE_VAL;
+	if (budgetedsearch() && !parents.empty()) {
+		incumbent = parents[0].score; // known, so exact
+	}
+	scorecandidates(model, unseen, known, optimizeforEDP, scored, incumbent);
+}
+
+std::string generateSurrogateProposal(std::string currentconfiguration,
+		std::string bestEXECconfiguration, std::string bestEDPconfiguration,
+		int /* optimizeforEXEC */, int optimizeforEDP) {
+	std::vector<ScoredCandidate> scored;
+	rankproposals(bestEXECconfiguration, bestEDPconfiguration, optimizeforEDP,
+			std::set<ConfigId>(), scored);
+	return scored.empty() ?
+			currentconfiguration : unpackconfiguration(scored[0].id);
+}
+
+void peekSurrogateProposals(std::string nextconfiguration,
+		std::string bestEXECconfiguration, std::string bestEDPconfiguration,
+		int /* optimizeforEXEC */, int optimizeforEDP, unsigned int count,
+		std::vector<std::string>& proposals) {
+	std::set<ConfigId> exclude;
+	exclude.insert(packconfiguration(nextconfiguration));
+	std::vector<ScoredCandidate> scored;
+	rankproposals(bestEXECconfiguration, bestEDPconfiguration, optimizeforEDP,
+			exclude, scored);
+	for (size_t n = 0; n < scored.size() && proposals.size() < count; ++n) {
+		proposals.push_back(unpackconfiguration(scored[n].id));
+	}
+}
+
+unsigned int evaluatesurrogate(std::ostream& out, int optimizeforEDP) {
+	EvaluationBatch history;
+	evaluatehistory(history);
+	if (history.ids.empty()) {
+		out << "surrogate: no complete results to replay" << std::endl;
+		return 0;
+	}
+	const std::vector<double>& objective =
+			optimizeforEDP ? history.geomeanEDP : history.geomeanTime;
+	double best = *std::min_element(objective.begin(), objective.end());
+	double threshold = 1.01 * best;
+	unsigned int good = 0;
+	std::map<ConfigId, double> truth;
+	ConfigMetrics metrics;
+	for (size_t n = 0; n < history.ids.size(); ++n) {
+		truth[history.ids[n]] = objective[n];
+		good += (objective[n] <= threshold);
+		metrics.benchmarks = lookupresults(history.ids[n], metrics.values);
+		GLOB_extracted_values[history.ids[n]] = metrics;
+	}
+
+	// Replay: start from the baseline, let the surrogate pick among the
+	// recorded configurations it has not been shown, and reveal each pick.
+	std::vector<ConfigId> revealed(1, packconfiguration(GLOB_baseline));
+	std::set<ConfigId> shown(revealed.begin(), revealed.end());
+	double found = truth.count(revealed[0]) ? truth[revealed[0]] : HUGE_VAL;
+	unsigned int simulations = 0;
+	while (found > threshold && shown.size() < truth.size()) {
+		SurrogateModel model;
+		fitsurrogate(revealed, model);
+		std::vector<ConfigId> candidates;
+		for (std::map<ConfigId, double>::iterator it = truth.begin();
+				it != truth.end(); ++it) {
+			if (!shown.count(it->first)) {
+				candidates.push_back(it->first);
+			}
+		}
+		std::vector<ScoredCandidate> scored;
+		scorecandidates(model, candidates, std::set<ConfigId>(),
+				optimizeforEDP, scored);
+		ConfigId pick = scored[0].id;
+		revealed.push_back(pick);
+		shown.insert(pick);
+		found = std::min(found, truth[pick]);
+		++simulations;
+	}
+
+	// Drawing without replacement hits one of good targets among N after
+	// (N + 1) / (good + 1) draws on average.
+	out << "surrogate: " << simulations << " of " << truth.size()
+			<< " recorded configurations simulated to reach within 1% of the"
+			<< " best " << (optimizeforEDP ? "EDP " : "time ") << best
+			<< " (random order: " << (truth.size() + 1.0) / (good + 1.0)
+			<< " expected)" << std::endl;
+	return simulations;
+}
@@ -0,0 +1,210 @@
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <time.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * Run telemetry, one JSON object per line:
+ *
+ *   {"event":"start",...}       target, search options, workers
+ *   {"event":"job",...}         a simulation job: wall seconds, exit status,
+ *                               whether it timed out, its attempt, and
+ *                               sim-outorder's own sim_elapsed_time and
+ *                               sim_inst_rate
+ *   {"event":"iteration",...}   one proposal: outcome and seconds per phase
+ *   {"event":"summary",...}     outcome counts, phase totals with log2
+ *                               histograms in microseconds, and per-benchmark
+ *                               job times with their tail percentiles,
+ *                               timeouts, retries and simulator speeds
+ *
+ * Lines go through a stdio buffer that is flushed once per iteration, and
+ * timing is a monotonic clock read per phase, so it stays on for every search.
+ */
+
+static const char* phaseNames[NUM_PHASES] = { "propose", "screen", "simulate",
+		"populate", "evaluate" };
+static const char* outcomeNames[NUM_OUTCOMES] = { "found", "simulated",
+		"pruned", "failed" };
+
+#define TELEMETRY_BUCKETS 40 // bucket b: below 2^b microseconds
+
+static FILE* telemetryfile = NULL;
+static double telemetryStart = 0;
+static double phaseSeconds[NUM_PHASES]; // since the last iteration event
+static double phaseTotals[NUM_PHASES];
+static unsigned long phaseHistogram[NUM_PHASES][TELEMETRY_BUCKETS];
+static unsigned long outcomeCounts[NUM_OUTCOMES];
+static unsigned long benchmarkJobs[NUM_BENCHMARKS];
+static double benchmarkJobSeconds[NUM_BENCHMARKS];
+static double benchmarkInstRate[NUM_BENCHMARKS]; // summed, for the mean
+static unsigned long benchmarkRated[NUM_BENCHMARKS];
+static std::vector<double> benchmarkWalls[NUM_BENCHMARKS]; // full windows
+static unsigned long benchmarkTimeouts[NUM_BENCHMARKS];
+static unsigned long benchmarkRetries[NUM_BENCHMARKS];
+
+double telemetryclock() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/*
+ * Configuration strings hold digits and spaces only, so need no escaping.
+ */
+void opentelemetry(std::string path, std::string target, std::string search,
+		int resumed) {
+	telemetryfile = fopen(path.c_str(), "a");
+	if (!telemetryfile) {
+		std::cerr << "Cannot open " << path << ", running without telemetry"
+				<< std::endl;
+		return;
+	}
+	setvbuf(telemetryfile, NULL, _IOFBF, 1 << 16);
+	telemetryStart = telemetryclock();
+	fprintf(telemetryfile, "{\"event\":\"start\",\"target\":\"%s\","
+			"\"search\":\"%s\",\"workers\":%u,\"resumed\":%d}\n",
+			target.c_str(), search.c_str(), GLOB_simulation_workers, resumed);
+	fflush(telemetryfile);
+}
+
+double telemetrylap(int phase, double since) {
+	double now = telemetryclock();
+	phaseSeconds[phase] += now - since;
+	return now;
+}
+
+void telemetryjob(std::string configuration, int benchmark,
+		unsigned int fidelity, double seconds, int outcome,
+		unsigned int attempt, const double speed[2]) {
+	if (0 == fidelity) { // screening jobs run shorter windows
+		benchmarkJobs[benchmark]++;
+		benchmarkJobSeconds[benchmark] += seconds;
+		benchmarkWalls[benchmark].push_back(seconds);
+	}
+	if (speed[1] > 0) {
+		benchmarkInstRate[benchmark] += speed[1];
+		benchmarkRated[benchmark]++;
+	}
+	if (JOB_TIMEDOUT == outcome) {
+		benchmarkTimeouts[benchmark]++;
+	}
+	if (attempt) {
+		benchmarkRetries[benchmark]++;
+	}
+	if (telemetryfile) {
+		fprintf(telemetryfile, "{\"event\":\"job\",\"configuration\":\"%s\","
+				"\"benchmark\":%d,\"fidelity\":%u,\"failed\":%d,"
+				"\"timed_out\":%d,\"attempt\":%u,\"seconds\":%.6f,"
+				"\"sim_elapsed_time\":%g,\"sim_inst_rate\":%g}\n",
+				configuration.c_str(), benchmark, fidelity, JOB_OK != outcome,
+				JOB_TIMEDOUT == outcome, attempt, seconds, speed[0], speed[1]);
+	}
+}
+
+/*
+ * The q-quantile of the full-window job times of a benchmark, nearest rank;
+ * sorts them in place.
+ */
+static double jobpercentile(int benchmark, double q) {
+	std::vector<double>& walls = benchmarkWalls[benchmark];
+	if (walls.empty()) {
+		return 0;
+	}
+	std::sort(walls.begin(), walls.end());
+	size_t rank = (size_t) ceil(q * walls.size());
+	return walls[rank ? rank - 1 : 0];
+}
+
+void printjobtails(std::ostream& out) {
+	char row[128];
+	out << "Simulation job seconds, full windows:" << std::endl
+			<< "  benchmark   jobs      p50      p90      p99      max"
+					"  timed out  retried" << std::endl;
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		snprintf(row, sizeof(row),
+				"  %-9d %6lu %8.3f %8.3f %8.3f %8.3f %10lu %8lu", i,
+				benchmarkJobs[i], jobpercentile(i, 0.5), jobpercentile(i, 0.9),
+				jobpercentile(i, 0.99), jobpercentile(i, 1), benchmarkTimeouts[i],
+				benchmarkRetries[i]);
+		out << row << std::endl;
+	}
+}
+
+void telemetryiteration(unsigned int iteration, std::string configuration,
+		int outcome) {
+	outcomeCounts[outcome]++;
+	for (int p = 0; p < NUM_PHASES; ++p) {
+		phaseTotals[p] += phaseSeconds[p];
+		double micros = phaseSeconds[p] * 1e6;
+		int bucket = 0;
+		while (bucket < TELEMETRY_BUCKETS - 1 && micros >= ldexp(1.0, bucket)) {
+			bucket++;
+		}
+		phaseHistogram[p][bucket]++;
+	}
+	if (telemetryfile) {
+		fprintf(telemetryfile, "{\"event\":\"iteration\",\"iteration\":%u,"
+				"\"configuration\":\"%s\",\"outcome\":\"%s\",\"seconds\":{",
+				iteration, configuration.c_str(), outcomeNames[outcome]);
+		for (int p = 0; p < NUM_PHASES; ++p) {
+			fprintf(telemetryfile, "%s\"%s\":%.6f", p ? "," : "", phaseNames[p],
+					phaseSeconds[p]);
+		}
+		fprintf(telemetryfile, "}}\n");
+		fflush(telemetryfile);
+	}
+	for (int p = 0; p < NUM_PHASES; ++p) {
+		phaseSeconds[p] = 0;
+	}
+}
+
+void closetelemetry() {
+	if (!telemetryfile) {
+		return;
+	}
+	unsigned long iterations = 0;
+	fprintf(telemetryfile, "{\"event\":\"summary\",\"wall_seconds\":%.3f,",
+			telemetryclock() - telemetryStart);
+	for (int o = 0; o < NUM_OUTCOMES; ++o) {
+		fprintf(telemetryfile, "\"%s\":%lu,", outcomeNames[o], outcomeCounts[o]);
+		iterations += outcomeCounts[o];
+	}
+	fprintf(telemetryfile, "\"hit_rate\":%.4f,\"phases\":{",
+			iterations ? (double) outcomeCounts[OUTCOME_FOUND] / iterations : 0);
+	for (int p = 0; p < NUM_PHASES; ++p) {
+		fprintf(telemetryfile, "%s\"%s\":{\"seconds\":%.6f,\"histogram_us\":[",
+				p ? "," : "", phaseNames[p], phaseTotals[p]);
+		int first = 1;
+		for (int b = 0; b < TELEMETRY_BUCKETS; ++b) {
+			if (phaseHistogram[p][b]) { // [below this many us, count]
+				fprintf(telemetryfile, "%s[%.0f,%lu]", first ? "" : ",",
+						ldexp(1.0, b), phaseHistogram[p][b]);
+				first = 0;
+			}
+		}
+		fprintf(telemetryfile, "]}");
+	}
+	fprintf(telemetryfile, "},\"benchmarks\":[");
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		fprintf(telemetryfile, "%s{\"benchmark\":%d,\"jobs\":%lu,"
+				"\"mean_seconds\":%.6f,\"p50_seconds\":%.6f,"
+				"\"p90_seconds\":%.6f,\"p99_seconds\":%.6f,"
+				"\"max_seconds\":%.6f,\"timed_out\":%lu,\"retried\":%lu,"
+				"\"mean_sim_inst_rate\":%g}", i ? "," : "", i, benchmarkJobs[i],
+				benchmarkJobs[i] ? benchmarkJobSeconds[i] / benchmarkJobs[i] : 0,
+				jobpercentile(i, 0.5), jobpercentile(i, 0.9),
+				jobpercentile(i, 0.99), jobpercentile(i, 1), benchmarkTimeouts[i],
+				benchmarkRetries[i],
+				benchmarkRated[i] ? benchmarkInstRate[i] / benchmarkRated[i] : 0);
+	}
+	fprintf(telemetryfile, "]}\n");
+	fclose(telemetryfile);
+	telemetryfile = NULL;
+}
@@ -0,0 +1,462 @@
+#ifdef DSE_TEST
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+#include "431project.h"
+
+/*
+ * Checks of the driver, built by "make test": the result store reads back
+ * what it recorded, also reopened; parsesimout() tells usable .simout files
+ * from broken ones; ranks and isvalidconfiguration() agree on the design
+ * space; the journal resumes past a torn last line; and the width bound never
+ * exceeds the geomean measured for any recorded configuration. Scratch files
+ * go to /tmp, so the recorded results are left alone.
+ *
+ * The nottaken check rebuilds the committed control transfers of each
+ * benchmark's baseline run from the bpred_nottaken counters its .simout
+ * records: dir_hits branches not taken, jr_seen returns, each after a call to
+ * its function, and the remaining misses as taken branches. Replayed through
+ * the baseline's branch setting, they must give the recorded counters back;
+ * the returns would hit in a RAS, which nottaken never consults.
+ */
+
+#define INSN_SIZE 8 // PISA instructions
+
+static unsigned int testChecks = 0;
+static unsigned int testFailures = 0;
+
+static void expect(std::string check, std::string name, double expected,
+		double actual) {
+	testChecks++;
+	if (expected != actual) {
+		std::cout << "FAIL " << check << ": " << name << " " << actual
+				<< ", recorded " << expected << std::endl;
+		testFailures++;
+	}
+}
+
+/*
+ * The counter called name in a .simout, -1 if absent.
+ */
+static double simoutcounter(std::string path, std::string name) {
+	std::ifstream simout(path.c_str());
+	std::string line;
+	while (std::getline(simout, line)) {
+		std::stringstream fields(line);
+		std::string field;
+		double value;
+		if (fields >> field && field == name && fields >> value) {
+			return value;
+		}
+	}
+	return -1;
+}
+
+static void testnottaken(int benchmark) {
+	ConfigId id = packconfiguration(GLOB_baseline);
+	std::string path = simoutpath(GLOB_baseline, benchmark, 0);
+	std::stringstream check;
+	check << "nottaken, benchmark " << benchmark;
+	double nottaken = simoutcounter(path, "bpred_nottaken.dir_hits");
+	double taken = simoutcounter(path, "bpred_nottaken.misses");
+	double returns = simoutcounter(path, "bpred_nottaken.jr_seen");
+	if (nottaken < 0 || taken < 0 || returns < 0) {
+		std::cout << "FAIL " << check.str() << ": no nottaken counters in "
+				<< path << std::endl;
+		testFailures++;
+		return;
+	}
+	double calls = std::min(returns, taken - returns);
+
+	std::vector<BranchRef> branches;
+	const uint32_t caller = 0x00400000, callee = 0x00500000;
+	const uint32_t loop = 0x00600000;
+	for (double r = 0; r < returns; ++r) {
+		uint32_t site = caller + INSN_SIZE * ((uint32_t) r % 256);
+		if (r < calls) {
+			BranchRef call = { site, callee, BRANCH_CALL };
+			branches.push_back(call);
+		}
+		BranchRef ret = { callee + 0x100, site + INSN_SIZE,
+				BRANCH_RETURN | BRANCH_INDIRECT };
+		branches.push_back(ret);
+	}
+	for (double n = 0; n < nottaken + taken - returns - calls; ++n) {
+		uint32_t pc = loop + INSN_SIZE * ((uint32_t) n % 64);
+		BranchRef branch = { pc,
+				(n < nottaken) ? pc + INSN_SIZE : loop - 0x40,
+				BRANCH_CONDITIONAL };
+		branches.push_back(branch);
+	}
+
+	std::vector<std::string> names;
+	std::vector<double> counts;
+	countbranches(branches, id, names, counts);
+	for (size_t k = 0; k < names.size(); ++k) {
+		// the trace holds committed branches, which sim-outorder updates
+		std::string recorded = names[k];
+		if (std::string::npos != recorded.find(".lookups")) {
+			recorded.replace(recorded.find(".lookups"), 8, ".updates");
+		}
+		expect(check.str(), names[k], simoutcounter(path, recorded),
+				counts[k]);
+	}
+}
+
+/*
+ * A scratch file under /tmp, "" if none could be made.
+ */
+static std::string scratchfile(std::string name) {
+	std::string path = "/tmp/" + name + ".XXXXXX";
+	std::vector<char> buffer(path.begin(), path.end());
+	buffer.push_back('\0');
+	int fd = mkstemp(&buffer[0]);
+	if (fd < 0) {
+		std::cout << "FAIL " << name << ": cannot create a scratch file"
+				<< std::endl;
+		testFailures++;
+		return "";
+	}
+	close(fd);
+	return &buffer[0];
+}
+
+static void writefile(std::string path, std::string contents) {
+	std::ofstream file(path.c_str(), std::ios::trunc);
+	file << contents;
+}
+
+/*
+ * Results of the n-th stored configuration, distinct per fidelity.
+ */
+static void storevalues(size_t n, unsigned int fidelity, double values[5][7]) {
+	for (int i = 0; i < 5; ++i) {
+		for (int j = 0; j < 7; ++j) {
+			values[i][j] = 1e6 * (fidelity + 1) + 100.0 * n + 10 * i + j;
+		}
+	}
+}
+
+static void expectstored(std::string check, ConfigId id, size_t n,
+		unsigned int fidelity, unsigned int mask) {
+	double values[5][7];
+	double expected[5][7];
+	storevalues(n, fidelity, expected);
+	std::string name = unpackconfiguration(id);
+	expect(check, name + " benchmarks", mask, lookupresults(id, values));
+	for (int i = 0; i < 5; ++i) {
+		for (int j = 0; (mask & (1 << i)) && j < 7; ++j) {
+			expect(check, name + " value", expected[i][j], values[i][j]);
+		}
+	}
+}
+
+/*
+ * Enough configurations to outgrow the first index, recorded in two steps,
+ * plus screening records of some; all must read back, before and after the
+ * store is reopened, and only the full ones count.
+ */
+static void teststore() {
+	std::string path = scratchfile("DSEtest.store");
+	if (path.empty() || 0 != openresultstore(path)) {
+		expect("store", "open", 0, 1);
+		return;
+	}
+	expect("store", "fresh configurations", 0, storedconfigurations());
+	const size_t count = 1500;
+	std::vector<ConfigId> ids;
+	for (size_t n = 0; n < count; ++n) {
+		ids.push_back(unrankconfiguration(
+				n * (validconfigurations() / count)));
+	}
+	for (size_t n = 0; n < count; ++n) {
+		double values[5][7];
+		storevalues(n, 0, values);
+		recordresults(ids[n], 0x07, values);
+		if (n % 2) {
+			recordresults(ids[n], 0x18, values);
+		}
+		if (0 == n % 10) {
+			storevalues(n, 1, values);
+			recordresults(setconfigfidelity(ids[n], 1), 0x1f, values);
+		}
+	}
+	for (int reopened = 0; reopened < 2; ++reopened) {
+		std::string check = reopened ? "store reopened" : "store";
+		expect(check, "configurations", count, storedconfigurations());
+		std::vector<ConfigId> listed;
+		storedconfigurationids(listed);
+		expect(check, "listed configurations", count, listed.size());
+		for (size_t n = 0; n < count; ++n) {
+			expectstored(check, ids[n], n, 0, (n % 2) ? 0x1f : 0x07);
+			if (0 == n % 10) {
+				expectstored(check, setconfigfidelity(ids[n], 1), n, 1, 0x1f);
+			} else {
+				expect(check, "unscreened " + unpackconfiguration(ids[n]), 0,
+						lookupresults(setconfigfidelity(ids[n], 1), NULL));
+			}
+		}
+		closeresultstore();
+		if (!reopened && 0 != openresultstore(path)) {
+			expect("store", "reopen", 0, 1);
+			break;
+		}
+	}
+	unlink(path.c_str());
+}
+
+/*
+ * The baseline's .simout parses in full; with a field undefined, missing or
+ * the statistics cut off it is unusable, and the error names the reason.
+ */
+static void testparsesimout() {
+	std::string baseline = simoutpath(GLOB_baseline, 0, 0);
+	std::ifstream file(baseline.c_str());
+	std::stringstream contents;
+	contents << file.rdbuf();
+	std::string recorded = contents.str();
+	double values[7];
+	double speed[2];
+	std::string error;
+	expect("parsesimout", baseline, SIMOUT_OK,
+			parsesimout(baseline, values, error, speed));
+	for (int j = 0; j < 7; ++j) {
+		std::string name = GLOB_fields[j].substr(0, GLOB_fields[j].size() - 1);
+		expect("parsesimout", name, simoutcounter(baseline, name), values[j]);
+	}
+	expect("parsesimout", "sim_elapsed_time",
+			simoutcounter(baseline, "sim_elapsed_time"), speed[0]);
+	expect("parsesimout", "sim_inst_rate",
+			simoutcounter(baseline, "sim_inst_rate"), speed[1]);
+
+	std::string path = scratchfile("DSEtest.simout");
+	if (path.empty()) {
+		return;
+	}
+	size_t misses = recorded.find("\n" + GLOB_fields[FIELD_UL2_MISSES]);
+	size_t accesses = recorded.find("\n" + GLOB_fields[FIELD_DL1_ACCESSES]);
+	size_t stats = recorded.find("sim: ** simulation statistics **");
+	if (std::string::npos == misses || std::string::npos == accesses
+			|| std::string::npos == stats) {
+		expect("parsesimout", "fields in " + baseline, 0, 1);
+		unlink(path.c_str());
+		return;
+	}
+	std::string undefined = recorded;
+	size_t value = misses + 1 + GLOB_fields[FIELD_UL2_MISSES].size();
+	undefined.replace(value, undefined.find('#', value) - value,
+			"<error: divide by zero> ");
+	writefile(path, undefined);
+	expect("parsesimout", "divide by zero", SIMOUT_INCOMPLETE,
+			parsesimout(path, values, error));
+	expect("parsesimout", "divide by zero value", 0,
+			values[FIELD_UL2_MISSES]);
+	expect("parsesimout", "divide by zero reported", 1,
+			std::string::npos != error.find("undefined ul2.misses"));
+
+	std::string missing = recorded;
+	missing.erase(accesses + 1, missing.find('\n', accesses + 1) - accesses);
+	writefile(path, missing);
+	expect("parsesimout", "missing field", SIMOUT_INCOMPLETE,
+			parsesimout(path, values, error));
+	expect("parsesimout", "missing field reported", 1,
+			std::string::npos != error.find("missing dl1.accesses"));
+
+	writefile(path, recorded.substr(0, stats));
+	expect("parsesimout", "no statistics", SIMOUT_TRUNCATED,
+			parsesimout(path, values, error));
+	writefile(path, "");
+	expect("parsesimout", "empty", SIMOUT_TRUNCATED,
+			parsesimout(path, values, error));
+	unlink(path.c_str());
+	expect("parsesimout", "absent", SIMOUT_MISSING,
+			parsesimout(path, values, error));
+}
+
+/*
+ * Every configuration over the head and cache dimensions, with the tail
+ * dimensions at their first and last values: isvalidconfiguration() must
+ * accept exactly as many as validconfigurations() counts, and each of those
+ * must rank within it and unrank back to itself.
+ */
+static void testspace() {
+	uint64_t total = validconfigurations();
+	const int tail[] = { 10, 11, 12, 13, 14 };
+	const int swept[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	const int sweptcount = sizeof(swept) / sizeof(swept[0]);
+	uint64_t tailcount = 1;
+	for (unsigned int t = 0; t < sizeof(tail) / sizeof(tail[0]); ++t) {
+		tailcount *= GLOB_dimensioncardinality[tail[t]];
+	}
+	for (int last = 0; last < 2; ++last) {
+		std::string check = last ? "space, last tail" : "space, first tail";
+		ConfigId fixed = 0;
+		for (unsigned int t = 0; t < sizeof(tail) / sizeof(tail[0]); ++t) {
+			fixed = setconfigparam(fixed, tail[t],
+					last ? GLOB_dimensioncardinality[tail[t]] - 1 : 0);
+		}
+		std::vector<unsigned int> value(sweptcount, 0);
+		uint64_t valid = 0;
+		unsigned int mismatches = 0;
+		for (;;) {
+			ConfigId id = fixed;
+			for (int s = 0; s < sweptcount; ++s) {
+				id = setconfigparam(id, swept[s], value[s]);
+			}
+			id = setcachelatencies(id);
+			if (isvalidconfiguration(id)) {
+				valid++;
+				uint64_t rank = rankconfiguration(id);
+				if (rank >= total || unrankconfiguration(rank) != id) {
+					if (0 == mismatches++) {
+						expect(check, "rank of " + unpackconfiguration(id), 1,
+								0);
+					}
+				}
+			}
+			int s = sweptcount - 1; // odometer, last dimension fastest
+			while (s >= 0
+					&& ++value[s] == GLOB_dimensioncardinality[swept[s]]) {
+				value[s--] = 0;
+			}
+			if (s < 0) {
+				break;
+			}
+		}
+		expect(check, "valid configurations", total, valid * tailcount);
+		expect(check, "rank mismatches", 0, mismatches);
+	}
+	unsigned int mismatches = 0;
+	for (uint64_t rank = 0; rank < total; rank += total / 100000 + 1) {
+		ConfigId id = unrankconfiguration(rank);
+		mismatches += !isvalidconfiguration(id)
+				|| rankconfiguration(id) != rank;
+	}
+	expect("space, sampled ranks", "mismatches", 0, mismatches);
+}
+
+/*
+ * Two progress records and a torn third: the journal resumes from the second,
+ * marks what both saw, and starts over once closed as finished.
+ */
+static void testjournal() {
+	std::string path = scratchfile("DSEtest.journal");
+	if (path.empty()) {
+		return;
+	}
+	SearchProgress progress;
+	expect("journal", "fresh", 0, openjournal(path, "test", progress));
+	std::vector<ConfigId> seen;
+	for (int k = 0; k < 3; ++k) {
+		seen.push_back(unrankconfiguration(12345 + 1000 * k));
+	}
+	progress.screeningspent = 1.5;
+	progress.simulationspent = 2.25;
+	progress.logbytes = 100;
+	progress.current = GLOB_baseline;
+	progress.bestTimeconfig = unpackconfiguration(seen[0]);
+	progress.bestTime = 0.5;
+	progress.bestEDPconfig = unpackconfiguration(seen[1]);
+	progress.bestEDP = 1.0 / 3;
+	progress.explorer = "0 0 0 0 0 2 0";
+	for (unsigned int k = 1; k <= 2; ++k) {
+		progress.iteration = k;
+		progress.seen.assign(1, unpackconfiguration(seen[k - 1]));
+		progress.finalists.assign(k - 1, unpackconfiguration(seen[2]));
+		journalprogress(progress);
+	}
+	closejournal(0);
+	std::ofstream torn(path.c_str(), std::ios::app);
+	torn << "iter 3 1.5 200 2.25|" << unpackconfiguration(seen[2]);
+	torn.close();
+
+	SearchProgress resumed;
+	expect("journal", "resumed", 1, openjournal(path, "test", resumed));
+	expect("journal", "iteration", 2, resumed.iteration);
+	expect("journal", "screeningspent", 1.5, resumed.screeningspent);
+	expect("journal", "simulationspent", 2.25, resumed.simulationspent);
+	expect("journal", "logbytes", 100, resumed.logbytes);
+	expect("journal", "bestEDP", 1.0 / 3, resumed.bestEDP);
+	expect("journal", "bestEDPconfig", 1,
+			progress.bestEDPconfig == resumed.bestEDPconfig);
+	expect("journal", "explorer", 1, progress.explorer == resumed.explorer);
+	expect("journal", "finalists", 1, resumed.finalists.size());
+	expect("journal", "seen first", 1, isconfigurationseen(seen[0]));
+	expect("journal", "seen second", 1, isconfigurationseen(seen[1]));
+	expect("journal", "torn line unseen", 0, isconfigurationseen(seen[2]));
+	closejournal(1);
+	expect("journal", "finished", 0, openjournal(path, "test", resumed));
+	closejournal(0);
+	expect("journal", "other header", 0, openjournal(path, "other", resumed));
+	closejournal(0);
+	unlink(path.c_str());
+}
+
+/*
+ * Over every recorded configuration, the width bound with any benchmarks
+ * left out must not exceed the measured geomean, for EDP and time alike.
+ */
+static void testbound() {
+	std::string path = scratchfile("DSEtest.store");
+	if (path.empty() || 0 != openresultstore(path)) {
+		expect("bound", "open", 0, 1);
+		return;
+	}
+	importresults(1);
+	std::vector<ConfigId> stored;
+	storedconfigurationids(stored);
+	unsigned int checked = 0;
+	for (size_t n = 0; n < stored.size(); ++n) {
+		double values[5][7];
+		if (0x1f != lookupresults(stored[n], values)) {
+			continue;
+		}
+		populate(unpackconfiguration(stored[n]));
+		for (int edp = 0; edp < 2; ++edp) {
+			double measured = edp ? calculategeomeanEDP(stored[n]) :
+					calculategeomeanExecutionTime(stored[n]);
+			for (unsigned int mask = 0; mask < 0x1f; ++mask) {
+				double bound = geomeanbound(stored[n], mask, values, edp);
+				if (bound > measured * (1 + 1e-12)) {
+					std::stringstream name;
+					name << unpackconfiguration(stored[n])
+							<< (edp ? " EDP" : " time") << " mask " << mask;
+					expect("bound", name.str(), measured, bound);
+				}
+			}
+		}
+		checked++;
+	}
+	expect("bound", "configurations checked", 1, checked > 0);
+	closeresultstore();
+	unlink(path.c_str());
+}
+
+int runtests(int, char**) {
+	teststore();
+	testparsesimout();
+	testspace();
+	testjournal();
+	testbound();
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		testnottaken(i);
+	}
+	std::cout << (testFailures ? "FAILED " : "passed ") << testChecks
+			<< " checks";
+	if (testFailures) {
+		std::cout << ", " << testFailures << " failed";
+	}
+	std::cout << std::endl;
+	return testFailures;
+}
+
+#endif
@@ -0,0 +1,711 @@
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+#include <math.h>
+
+#include "431project.h"
+
+/*
+ * Trace-driven cache estimates.
+ *
+ * runprojectsuite.sh with "ptrace" as 20th argument leaves a pipetrace of the
+ * run next to its .simout. It is reduced here to the committed instruction
+ * fetches, kept as <benchmark>.<configuration>.trace, and to the committed
+ * control transfers, kept as .btrace for the branch estimates (see
+ * 431projectBranch.cpp).
+ *
+ * The pipetrace has no data addresses: sim-outorder opens every instruction
+ * with ptrace_newinst(..., 0), so the address field of a "+" line is always 0,
+ * and no later stage reports one. Only the instruction side is estimated
+ * therefore: configurations that differ from the traced one in il1sets,
+ * il1assoc and il1lat alone. Their ul2 counters change by what the il1 miss
+ * stream does to a ul2 of the traced geometry on its own; the data it shares
+ * the ul2 with is not modelled, so these are rough estimates, not
+ * predictions, and the ul2 ones the roughest.
+ *
+ * From one trace, the il1 and ul2 counters of any il1 geometry follow in a
+ * pass over the fetches:
+ *
+ * - LRU caches of equal sets and block size share one stack per set, as deep
+ *   as the largest associativity asked for. A fetch at stack depth d misses
+ *   in every cache with at most d ways.
+ * - FIFO and random caches are simulated directly, one per associativity.
+ * - The il1 miss stream of each il1 variant is replayed into the ul2 the
+ *   same way. Fetches never write, so the ul2 writebacks stay as measured.
+ *
+ * The counters are applied as differences from the measured run the trace
+ * came from, so what the reduced trace misses (wrong-path fetches, refetches)
+ * largely cancels. sim_cycle is the measured cycles plus the change in il1
+ * and ul2 miss stall cycles, scaled by overlap factors fitted to recorded runs
+ * that differ in the il1 alone when there are enough of them.
+ */
+
+#define TRACE_VERSION 2
+#define TRACE_CALIBRATION_MIN 8 // recorded runs needed to fit overlap factors
+#define TRACE_STALLS 2 // il1 misses, ul2 misses
+
+static const char traceMagic[8] = { 'D', 'S', 'E', 'T', 'R', 'A', 'C', 'E' };
+
+struct BenchmarkTrace {
+	ConfigId capture; // configuration the trace was recorded on
+	std::vector<uint32_t> fetches; // committed fetch addresses
+	double overlap[TRACE_STALLS]; // cycles per stall cycle
+	int calibrated;
+};
+
+static BenchmarkTrace traces[NUM_BENCHMARKS];
+static unsigned int traceMask = 0;
+
+// First-order overlap factors: instruction misses stall fetch outright,
+// memory stalls are partly hidden behind other work.
+static const double defaultOverlap[TRACE_STALLS] = { 1.0, 0.5 };
+
+// il1sets, il1assoc, il1lat: everything else must match the traced
+// configuration.
+static const int traceCacheDims[] = { 5, 6, 16 };
+
+/*
+ * BRANCH_ flags of a PISA control transfer, -1 for any other instruction.
+ * Returns are "jr $31", however the disassembler names the register.
+ */
+static int branchkind(const char* mnemonic, const char* operands) {
+	static const char* conditionals[] = { "beq", "bne", "blez", "bgtz", "bltz",
+			"bgez", "bc1f", "bc1t" };
+	for (unsigned int i = 0;
+			i < sizeof(conditionals) / sizeof(conditionals[0]); ++i) {
+		if (0 == strcmp(mnemonic, conditionals[i])) {
+			return BRANCH_CONDITIONAL;
+		}
+	}
+	if (0 == strcmp(mnemonic, "j")) {
+		return 0;
+	} else if (0 == strcmp(mnemonic, "jal")) {
+		return BRANCH_CALL;
+	} else if (0 == strcmp(mnemonic, "jalr")) {
+		return BRANCH_CALL | BRANCH_INDIRECT;
+	} else if (0 == strcmp(mnemonic, "jr")) {
+		size_t length = strlen(operands);
+		int returns = (length >= 2 && 0 == strcmp(operands + length - 2, "31"))
+				|| 0 == strcmp(operands, "$ra");
+		return BRANCH_INDIRECT | (returns ? BRANCH_RETURN : 0);
+	}
+	return -1;
+}
+
+/*
+ * Reduces a sim-outorder pipetrace to committed fetches and control
+ * transfers, in commit order. "+ <seq> <pc> <addr> <insn>" opens an
+ * instruction, "* <seq> CT ..." commits it and "- <seq>" retires it,
+ * committed or squashed; <addr> is always 0, so only the fetch is kept. A
+ * control transfer is complete once the instruction committed after it tells
+ * where it went.
+ */
+static int convertptrace(std::string path, std::vector<uint32_t>& fetches,
+		std::vector<BranchRef>& branches) {
+	FILE* ptrace = fopen(path.c_str(), "r");
+	if (!ptrace) {
+		return -1;
+	}
+	std::map<unsigned int, uint32_t> inflight; // fetch PCs
+	std::map<unsigned int, int> control; // branchkind() of each
+	BranchRef pending = { 0, 0, 0 };
+	int haspending = 0;
+	char line[512];
+	while (fgets(line, sizeof(line), ptrace)) {
+		unsigned int seq;
+		if ('+' == line[0]) {
+			unsigned int pc, address;
+			char mnemonic[32];
+			char operands[64] = "";
+			if (4 <= sscanf(line, "+ %u 0x%x 0x%x %31s %63s", &seq, &pc,
+					&address, mnemonic, operands)) {
+				inflight[seq] = pc;
+				control[seq] = branchkind(mnemonic, operands);
+			}
+		} else if ('*' == line[0]) {
+			char stage[8];
+			if (2 == sscanf(line, "* %u %7s", &seq, stage)
+					&& 0 == strcmp(stage, "CT") && inflight.count(seq)) {
+				uint32_t pc = inflight[seq];
+				fetches.push_back(pc);
+				if (haspending) {
+					pending.next = pc;
+					branches.push_back(pending);
+				}
+				haspending = control[seq] >= 0;
+				pending.pc = pc;
+				pending.kind = control[seq];
+				inflight.erase(seq);
+				control.erase(seq);
+			}
+		} else if ('-' == line[0] && 1 == sscanf(line, "- %u", &seq)) {
+			inflight.erase(seq);
+			control.erase(seq);
+		}
+	}
+	fclose(ptrace);
+	return 0;
+}
+
+static int writetrace(std::string path,
+		const std::vector<uint32_t>& fetches) {
+	FILE* trace = fopen(path.c_str(), "wb");
+	if (!trace) {
+		return -1;
+	}
+	uint32_t version = TRACE_VERSION;
+	uint64_t count = fetches.size();
+	int ok = 1 == fwrite(traceMagic, sizeof(traceMagic), 1, trace)
+			&& 1 == fwrite(&version, sizeof(version), 1, trace)
+			&& 1 == fwrite(&count, sizeof(count), 1, trace)
+			&& (0 == count
+					|| count == fwrite(&fetches[0], sizeof(uint32_t), count, trace));
+	return (0 == fclose(trace) && ok) ? 0 : -1;
+}
+
+static int readtrace(std::string path, std::vector<uint32_t>& fetches) {
+	FILE* trace = fopen(path.c_str(), "rb");
+	if (!trace) {
+		return -1;
+	}
+	char magic[8];
+	uint32_t version;
+	uint64_t count;
+	int ok = 1 == fread(magic, sizeof(magic), 1, trace)
+			&& 0 == memcmp(magic, traceMagic, sizeof(magic))
+			&& 1 == fread(&version, sizeof(version), 1, trace)
+			&& TRACE_VERSION == version
+			&& 1 == fread(&count, sizeof(count), 1, trace);
+	if (ok) {
+		fetches.resize(count);
+		ok = 0 == count
+				|| count == fread(&fetches[0], sizeof(uint32_t), count, trace);
+	}
+	fclose(trace);
+	return ok ? 0 : -1;
+}
+
+/*
+ * A cache level and the block addresses it fills from the level below, in
+ * trace order.
+ */
+struct CacheLevel {
+	unsigned int assoc;
+	uint64_t accesses;
+	uint64_t misses;
+	std::vector<uint32_t> traffic;
+	// FIFO and random only
+	std::vector<uint32_t> blocks; // sets * assoc, NO_BLOCK when invalid
+	std::vector<unsigned int> next; // FIFO victim per set
+};
+
+#define NO_BLOCK 0xffffffffu
+
+/*
+ * Caches of one sets/block size/policy, one level per associativity.
+ */
+struct CacheGroup {
+	unsigned int sets;
+	unsigned int blockbits;
+	unsigned int policy; // replacepolicy index: 0 LRU, 1 FIFO, 2 random
+	int recordtraffic;
+	std::vector<CacheLevel> levels; // ascending associativity
+	// LRU only: per set stack of blocks, most recent first
+	unsigned int depth;
+	std::vector<uint32_t> stack;
+	std::vector<unsigned int> stacksize;
+	uint32_t random; // xorshift state
+};
+
+static void initgroup(CacheGroup& group, unsigned int sets,
+		unsigned int blocksize, unsigned int policy,
+		const std::set<unsigned int>& assocs, int recordtraffic) {
+	group.sets = sets;
+	group.blockbits = __builtin_ctz(blocksize);
+	group.policy = policy;
+	group.recordtraffic = recordtraffic;
+	group.levels.clear();
+	for (std::set<unsigned int>::const_iterator it = assocs.begin();
+			it != assocs.end(); ++it) {
+		CacheLevel level;
+		level.assoc = *it;
+		level.accesses = level.misses = 0;
+		if (0 != policy) {
+			level.blocks.assign(sets * *it, NO_BLOCK);
+			level.next.assign(sets, 0);
+		}
+		group.levels.push_back(level);
+	}
+	group.depth = *assocs.rbegin();
+	if (0 == policy) {
+		group.stack.assign(sets * group.depth, NO_BLOCK);
+		group.stacksize.assign(sets, 0);
+	}
+	group.random = 2463534242u;
+}
+
+static inline void fill(CacheGroup& group, CacheLevel& level, uint32_t block) {
+	if (group.recordtraffic) {
+		level.traffic.push_back(block << group.blockbits);
+	}
+}
+
+static void lruaccess(CacheGroup& group, uint32_t address) {
+	uint32_t block = address >> group.blockbits;
+	unsigned int set = block & (group.sets - 1);
+	uint32_t* stack = &group.stack[set * group.depth];
+	unsigned int& size = group.stacksize[set];
+	unsigned int d = 0;
+	while (d < size && stack[d] != block) {
+		++d;
+	}
+	int found = d < size;
+	for (unsigned int k = 0; k < group.levels.size(); ++k) {
+		CacheLevel& level = group.levels[k];
+		level.accesses++;
+		if (found && d < level.assoc) {
+			continue; // hit
+		}
+		level.misses++;
+		fill(group, level, block);
+	}
+	unsigned int last;
+	if (found) {
+		last = d;
+	} else if (size < group.depth) {
+		last = size++;
+	} else {
+		last = group.depth - 1; // drops out of every level
+	}
+	memmove(stack + 1, stack, last * sizeof(uint32_t));
+	stack[0] = block;
+}
+
+static void directaccess(CacheGroup& group, uint32_t address) {
+	uint32_t block = address >> group.blockbits;
+	unsigned int set = block & (group.sets - 1);
+	for (unsigned int k = 0; k < group.levels.size(); ++k) {
+		CacheLevel& level = group.levels[k];
+		uint32_t* ways = &level.blocks[set * level.assoc];
+		level.accesses++;
+		unsigned int way = 0;
+		while (way < level.assoc && ways[way] != block) {
+			++way;
+		}
+		if (way < level.assoc) {
+			continue;
+		}
+		level.misses++;
+		if (1 == group.policy) { // FIFO: oldest fill goes first
+			way = level.next[set];
+			level.next[set] = (way + 1) % level.assoc;
+		} else { // random, like sim-outorder's, regardless of free ways
+			group.random ^= group.random << 13;
+			group.random ^= group.random >> 17;
+			group.random ^= group.random << 5;
+			way = group.random & (level.assoc - 1);
+		}
+		fill(group, level, block);
+		ways[way] = block;
+	}
+}
+
+static inline void cacheaccess(CacheGroup& group, uint32_t address) {
+	if (0 == group.policy) {
+		lruaccess(group, address);
+	} else {
+		directaccess(group, address);
+	}
+}
+
+/*
+ * Raw engine counters of one benchmark of one configuration.
+ */
+struct CacheCounters {
+	double il1misses;
+	double ul2accesses;
+	double ul2misses;
+};
+
+/*
+ * Runs the fetches of one benchmark through the caches of every given
+ * configuration. il1 caches first, in one pass over the trace; then each
+ * distinct il1 miss stream through its ul2 caches.
+ */
+static void simulatecaches(const BenchmarkTrace& trace,
+		const std::vector<ConfigId>& ids, std::vector<CacheCounters>& counters) {
+	// il1 groups, keyed by block size, policy and sets.
+	std::map<unsigned int, std::set<unsigned int> > assocs;
+	std::vector<unsigned int> l1keys(ids.size());
+	for (size_t n = 0; n < ids.size(); ++n) {
+		l1keys[n] = (configparam(ids[n], 2) << 8)
+				| (configparam(ids[n], 10) << 4) | configparam(ids[n], 5);
+		assocs[l1keys[n]].insert(1 << configparam(ids[n], 6));
+	}
+	std::map<unsigned int, CacheGroup> l1groups;
+	std::vector<CacheGroup*> routes;
+	for (std::map<unsigned int, std::set<unsigned int> >::iterator it =
+			assocs.begin(); it != assocs.end(); ++it) {
+		CacheGroup& group = l1groups[it->first];
+		initgroup(group, 32 << (it->first & 0xf), 8 << (it->first >> 8),
+				(it->first >> 4) & 0xf, it->second, 1);
+		routes.push_back(&group);
+	}
+	for (size_t r = 0; r < trace.fetches.size(); ++r) {
+		for (size_t g = 0; g < routes.size(); ++g) {
+			cacheaccess(*routes[g], trace.fetches[r]);
+		}
+	}
+
+	// ul2 groups, keyed by the il1 level feeding them and the ul2 sets,
+	// block size and policy.
+	typedef std::pair<CacheLevel*, unsigned int> L2Key;
+	std::map<L2Key, std::set<unsigned int> > l2assocs;
+	std::vector<L2Key> keys(ids.size());
+	for (size_t n = 0; n < ids.size(); ++n) {
+		CacheGroup& il1 = l1groups[l1keys[n]];
+		CacheLevel* il1level = NULL;
+		for (size_t k = 0; k < il1.levels.size(); ++k) {
+			if (il1.levels[k].assoc == (1u << configparam(ids[n], 6))) {
+				il1level = &il1.levels[k];
+			}
+		}
+		keys[n] = L2Key(il1level,
+				(configparam(ids[n], 7) << 8) | (configparam(ids[n], 8) << 4)
+						| configparam(ids[n], 10));
+		l2assocs[keys[n]].insert(1 << configparam(ids[n], 9));
+	}
+	std::map<L2Key, CacheGroup> l2groups;
+	for (std::map<L2Key, std::set<unsigned int> >::iterator it =
+			l2assocs.begin(); it != l2assocs.end(); ++it) {
+		CacheGroup& group = l2groups[it->first];
+		unsigned int geometry = it->first.second;
+		initgroup(group, 256 << (geometry >> 8), 16 << ((geometry >> 4) & 0xf),
+				geometry & 0xf, it->second, 0);
+		const std::vector<uint32_t>& traffic = it->first.first->traffic;
+		for (size_t e = 0; e < traffic.size(); ++e) {
+			cacheaccess(group, traffic[e]);
+		}
+	}
+
+	counters.resize(ids.size());
+	for (size_t n = 0; n < ids.size(); ++n) {
+		CacheCounters& c = counters[n];
+		c.il1misses = keys[n].first->misses;
+		CacheGroup& l2 = l2groups[keys[n]];
+		for (size_t k = 0; k < l2.levels.size(); ++k) {
+			if (l2.levels[k].assoc == (1u << configparam(ids[n], 9))) {
+				c.ul2accesses = l2.levels[k].accesses;
+				c.ul2misses = l2.levels[k].misses;
+			}
+		}
+	}
+}
+
+/*
+ * Stall cycles of a configuration that the overlap factors scale: il1 misses
+ * and ul2 misses. Latencies as runprojectsuite.sh passes them to sim-outorder.
+ */
+static void stallcycles(ConfigId id, const CacheCounters& c,
+		double stalls[TRACE_STALLS]) {
+	double ul2latency = 5 + configparam(id, 17);
+	double memorylatency = 51 + 7 * ((16 << configparam(id, 8)) / 8 - 1);
+	stalls[0] = c.il1misses * ul2latency;
+	stalls[1] = c.ul2misses * memorylatency;
+}
+
+static int istraceable(const BenchmarkTrace& trace, ConfigId id) {
+	ConfigId mask = 0;
+	for (unsigned int i = 0; i < sizeof(traceCacheDims) / sizeof(traceCacheDims[0]);
+			++i) {
+		mask = setconfigparam(mask, traceCacheDims[i],
+				(1u << GLOB_dimensionbits[traceCacheDims[i]]) - 1);
+	}
+	return (id & ~mask) == (trace.capture & ~mask);
+}
+
+/*
+ * Fits the overlap factors of a benchmark to recorded runs that differ from
+ * the traced configuration in the cache dimensions only, by least squares
+ * pulled towards the defaults.
+ */
+static void calibratetrace(BenchmarkTrace& trace, int benchmark,
+		const double reference[NUM_FIELDS],
+		const CacheCounters& referencecounters) {
+	std::copy(defaultOverlap, defaultOverlap + TRACE_STALLS, trace.overlap);
+	trace.calibrated = 0;
+	std::vector<ConfigId> stored, runs;
+	storedconfigurationids(stored);
+	for (size_t n = 0; n < stored.size(); ++n) {
+		if (stored[n] != trace.capture && istraceable(trace, stored[n])
+				&& (lookupresults(stored[n], NULL) & (1 << benchmark))) {
+			runs.push_back(stored[n]);
+		}
+	}
+	if (runs.size() < TRACE_CALIBRATION_MIN) {
+		return;
+	}
+	std::vector<CacheCounters> counters;
+	simulatecaches(trace, runs, counters);
+	double base[TRACE_STALLS];
+	stallcycles(trace.capture, referencecounters, base);
+	// [X^T X + mu I | X^T y + mu c0]
+	double normal[TRACE_STALLS][TRACE_STALLS + 1] = { { 0 } };
+	double mu = 0.0;
+	for (size_t n = 0; n < runs.size(); ++n) {
+		double values[5][7];
+		lookupresults(runs[n], values);
+		double stalls[TRACE_STALLS];
+		stallcycles(runs[n], counters[n], stalls);
+		double y = values[benchmark][FIELD_SIM_CYCLE]
+				- reference[FIELD_SIM_CYCLE];
+		for (int r = 0; r < TRACE_STALLS; ++r) {
+			double xr = stalls[r] - base[r];
+			for (int c = 0; c < TRACE_STALLS; ++c) {
+				normal[r][c] += xr * (stalls[c] - base[c]);
+			}
+			normal[r][TRACE_STALLS] += xr * y;
+		}
+	}
+	for (int r = 0; r < TRACE_STALLS; ++r) {
+		mu += normal[r][r];
+	}
+	mu = 1e-3 * mu / TRACE_STALLS + 1e-9;
+	for (int r = 0; r < TRACE_STALLS; ++r) {
+		normal[r][r] += mu;
+		normal[r][TRACE_STALLS] += mu * defaultOverlap[r];
+	}
+	// Gaussian elimination, SPD so no pivoting
+	for (int p = 0; p < TRACE_STALLS; ++p) {
+		for (int r = p + 1; r < TRACE_STALLS; ++r) {
+			double f = normal[r][p] / normal[p][p];
+			for (int c = p; c <= TRACE_STALLS; ++c) {
+				normal[r][c] -= f * normal[p][c];
+			}
+		}
+	}
+	for (int r = TRACE_STALLS - 1; r >= 0; --r) {
+		double sum = normal[r][TRACE_STALLS];
+		for (int c = r + 1; c < TRACE_STALLS; ++c) {
+			sum -= normal[r][c] * trace.overlap[c];
+		}
+		trace.overlap[r] = sum / normal[r][r];
+	}
+	trace.calibrated = runs.size();
+}
+
+int traceconfiguration(std::string name, std::string suffix, int* benchmark,
+		ConfigId* capture) {
+	if (name.size() != 2 + NUM_DIMS * 2 - 1 + suffix.size() || '.' != name[1]
+			|| 0 != name.compare(name.size() - suffix.size(), suffix.size(),
+							suffix) || name[0] < '0' || name[0] > '4') {
+		return 0;
+	}
+	std::string configuration = name.substr(2, NUM_DIMS * 2 - 1);
+	std::replace(configuration.begin(), configuration.end(), '.', ' ');
+	*benchmark = name[0] - '0';
+	*capture = packconfiguration(configuration);
+	return isvalidconfiguration(*capture);
+}
+
+void listoutputs(std::vector<std::string>& names) {
+	names.clear();
+	DIR* dir = opendir(GLOB_outputpath.c_str());
+	if (!dir) {
+		return;
+	}
+	struct dirent* entry;
+	while ((entry = readdir(dir))) {
+		names.push_back(entry->d_name);
+	}
+	closedir(dir);
+	std::sort(names.begin(), names.end());
+}
+
+void reducepipetraces() {
+	std::vector<std::string> names;
+	listoutputs(names);
+	for (size_t n = 0; n < names.size(); ++n) {
+		int benchmark;
+		ConfigId capture;
+		if (traceconfiguration(names[n], ".ptrace", &benchmark, &capture)) {
+			std::vector<uint32_t> fetches;
+			std::vector<BranchRef> branches;
+			std::string base = GLOB_outputpath
+					+ names[n].substr(0, names[n].size() - 7);
+			if (0 == convertptrace(GLOB_outputpath + names[n], fetches, branches)
+					&& !fetches.empty() && 0 == writetrace(base + ".trace", fetches)
+					&& 0 == writebranchtrace(base + ".btrace", branches)) {
+				unlink((GLOB_outputpath + names[n]).c_str());
+			} else {
+				std::cerr << "cannot reduce pipetrace " << names[n]
+						<< std::endl;
+			}
+		}
+	}
+}
+
+unsigned int loadtraces() {
+	// Reduce fresh pipetraces first; they are large and only needed once.
+	reducepipetraces();
+	std::vector<std::string> names;
+	listoutputs(names);
+	for (size_t n = 0; n < names.size(); ++n) {
+		int benchmark;
+		ConfigId capture;
+		if (!traceconfiguration(names[n], ".trace", &benchmark, &capture)
+				|| (traceMask & (1 << benchmark))) {
+			continue;
+		}
+		BenchmarkTrace& trace = traces[benchmark];
+		if (0 != readtrace(GLOB_outputpath + names[n], trace.fetches)) {
+			std::cerr << "cannot read trace " << names[n] << std::endl;
+			continue;
+		}
+		double reference[5][7];
+		if (!(lookupresults(capture, reference) & (1 << benchmark))) {
+			std::cerr << "trace " << names[n]
+					<< " has no recorded run to start from" << std::endl;
+			trace.fetches.clear();
+			continue;
+		}
+		trace.capture = capture;
+		std::vector<CacheCounters> counters;
+		simulatecaches(trace, std::vector<ConfigId>(1, capture), counters);
+		calibratetrace(trace, benchmark, reference[benchmark], counters[0]);
+		traceMask |= 1 << benchmark;
+	}
+	return traceMask;
+}
+
+unsigned int estimatecaches(const std::vector<ConfigId>& ids,
+		std::vector<ConfigMetrics>& metrics) {
+	metrics.assign(ids.size(), ConfigMetrics());
+	unsigned int estimated = 0;
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		if (!(traceMask & (1 << i))) {
+			continue;
+		}
+		BenchmarkTrace& trace = traces[i];
+		std::vector<ConfigId> batch(1, trace.capture);
+		std::vector<size_t> slots;
+		for (size_t n = 0; n < ids.size(); ++n) {
+			if (isvalidconfiguration(ids[n]) && istraceable(trace, ids[n])) {
+				batch.push_back(ids[n]);
+				slots.push_back(n);
+			}
+		}
+		std::vector<CacheCounters> counters;
+		simulatecaches(trace, batch, counters);
+		double reference[5][7];
+		lookupresults(trace.capture, reference);
+		const double* measured = reference[i];
+		const CacheCounters& base = counters[0];
+		double basestalls[TRACE_STALLS];
+		stallcycles(trace.capture, base, basestalls);
+		for (size_t s = 0; s < slots.size(); ++s) {
+			const CacheCounters& c = counters[s + 1];
+			double stalls[TRACE_STALLS];
+			stallcycles(batch[s + 1], c, stalls);
+			double cycles = measured[FIELD_SIM_CYCLE];
+			for (int k = 0; k < TRACE_STALLS; ++k) {
+				cycles += trace.overlap[k] * (stalls[k] - basestalls[k]);
+			}
+			double* values = metrics[slots[s]].values[i];
+			values[FIELD_SIM_NUM_INSN] = measured[FIELD_SIM_NUM_INSN];
+			values[FIELD_SIM_CYCLE] = std::max(cycles,
+					measured[FIELD_SIM_NUM_INSN] / 8); // width 8 at best
+			// Every il1 miss refetches.
+			values[FIELD_IL1_ACCESSES] = std::max(0.0,
+					measured[FIELD_IL1_ACCESSES] + c.il1misses - base.il1misses);
+			values[FIELD_DL1_ACCESSES] = measured[FIELD_DL1_ACCESSES];
+			values[FIELD_UL2_ACCESSES] = std::max(0.0,
+					measured[FIELD_UL2_ACCESSES] + c.ul2accesses
+							- base.ul2accesses);
+			values[FIELD_UL2_MISSES] = std::max(0.0,
+					measured[FIELD_UL2_MISSES] + c.ul2misses - base.ul2misses);
+			values[FIELD_UL2_WRITEBACKS] = measured[FIELD_UL2_WRITEBACKS];
+			metrics[slots[s]].benchmarks |= 1 << i;
+		}
+	}
+	for (size_t n = 0; n < ids.size(); ++n) {
+		estimated += (0x1f == metrics[n].benchmarks);
+	}
+	return estimated;
+}
+
+void printcacheestimates(std::ostream& out, ConfigId center) {
+	if (0x1f != traceMask) {
+		for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+			if (!(traceMask & (1 << i))) {
+				out << "no trace for benchmark " << i << "; capture one with"
+						<< " ./runprojectsuite.sh " << unpackconfiguration(center)
+						<< " " << i << " ptrace" << std::endl;
+			}
+		}
+		return;
+	}
+	for (int i = 0; i < NUM_BENCHMARKS; ++i) {
+		out << "benchmark " << i << " overlap factors";
+		for (int k = 0; k < TRACE_STALLS; ++k) {
+			out << " " << traces[i].overlap[k];
+		}
+		if (traces[i].calibrated) {
+			out << " (fitted to " << traces[i].calibrated << " recorded runs)";
+		} else {
+			out << " (defaults)";
+		}
+		out << std::endl;
+	}
+	// Every configuration one il1 dimension away from center.
+	std::vector<ConfigId> ids(1, center);
+	for (int dim = 5; dim <= 6; ++dim) {
+		for (unsigned int value = 0; value < GLOB_dimensioncardinality[dim];
+				++value) {
+			ConfigId id = setcachelatencies(setconfigparam(center, dim, value));
+			if (value != configparam(center, dim) && isvalidconfiguration(id)) {
+				ids.push_back(id);
+			}
+		}
+	}
+	std::vector<ConfigMetrics> metrics;
+	estimatecaches(ids, metrics);
+	EvaluationBatch batch;
+	for (size_t n = 0; n < ids.size(); ++n) {
+		if (0x1f == metrics[n].benchmarks) {
+			batch.add(ids[n], metrics[n]);
+		}
+	}
+	evaluatebatch(batch, 0);
+	out << "Rough instruction-side estimates: the pipetrace has no data"
+			<< " addresses, so the ul2" << std::endl
+			<< "counters leave out what the data does to it" << std::endl
+			<< "config,estimated normEDP,estimated normTime,estimated EDP,"
+			<< "estimated Time,measured EDP,measured Time" << std::endl;
+	for (size_t n = 0; n < batch.ids.size(); ++n) {
+		out << unpackconfiguration(batch.ids[n]) << ","
+				<< batch.geomeanEDP[n] / GLOB_baseline_EP_pair.first << ","
+				<< batch.geomeanTime[n] / GLOB_baseline_EP_pair.second << ","
+				<< batch.geomeanEDP[n] << "," << batch.geomeanTime[n] << ",";
+		if (isconfigurationsimulated(batch.ids[n])) {
+			if (!isconfigurationloaded(unpackconfiguration(batch.ids[n]))) {
+				loadresults(unpackconfiguration(batch.ids[n]));
+			}
+			out << calculategeomeanEDP(batch.ids[n]) << ","
+					<< calculategeomeanExecutionTime(batch.ids[n]);
+		} else {
+			out << ",";
+		}
+		out << std::endl;
+	}
+}
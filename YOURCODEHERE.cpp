@@ -12,6 +12,7 @@
 #include <fcntl.h>
 #include <vector>
 #include <iterator>
+#include <stdint.h>
 
 #include "431project.h"
 
@@ -30,13 +31,73 @@ using namespace std;
 #define KILOBYTE 1024
 
 int order[15] = { 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0, 1, 12, 13, 14 };
-int dimensionIndex = 0;
-int choiceIndex = 0;
-int traversalIndex = 0;
-bool currentDimDone = false;
-bool isDSEComplete = false;
-unsigned int currentlyExploringDim = order[dimensionIndex];
-std::string bestTraversalConfig = "";
+
+/*
+ * Heuristic progress, kept together so that upcoming proposals can be worked
+ * out on a copy without disturbing the real traversal.
+ */
+struct ExplorerState {
+	int dimensionIndex;
+	int choiceIndex;
+	int traversalIndex;
+	bool currentDimDone;
+	bool isDSEComplete;
+	unsigned int currentlyExploringDim;
+	ConfigId bestTraversalConfig;
+};
+
+ExplorerState explorer = { 0, 0, 0, false, false, 2 /* order[0] */, NO_CONFIG };
+
+/*
+ * What a traversal sweeps, step by step: by default every dimension of order
+ * alone, else the plan set by main-effects screening.
+ */
+static std::vector<SweepStep> defaultsweepplan() {
+	std::vector<SweepStep> plan;
+	for (int d = 0; d < NUM_DIMS - NUM_DIMS_DEPENDENT; ++d) {
+		SweepStep step = { order[d], -1 };
+		plan.push_back(step);
+	}
+	return plan;
+}
+
+static std::vector<SweepStep> sweepPlan = defaultsweepplan();
+static SweepPlanner sweepPlanner = NULL;
+
+void setsweepplan(const std::vector<SweepStep>& plan) {
+	sweepPlan = plan;
+	explorer.dimensionIndex = 0;
+	explorer.choiceIndex = 0;
+	explorer.currentDimDone = false;
+	explorer.currentlyExploringDim = sweepPlan[0].dim;
+}
+
+void setsweepplanner(SweepPlanner planner) {
+	sweepPlanner = planner;
+}
+
+unsigned int heuristictraversals() {
+	return explorer.traversalIndex + 1;
+}
+
+/*
+ * Number of points in a sweep step, and the one at choice: a joint step walks
+ * the partner fastest.
+ */
+static unsigned int sweepsize(const SweepStep& step) {
+	return GLOB_dimensioncardinality[step.dim]
+			* (step.partner < 0 ? 1 : GLOB_dimensioncardinality[step.partner]);
+}
+
+static ConfigId sweeppoint(ConfigId best, const SweepStep& step,
+		unsigned int choice) {
+	if (step.partner < 0) {
+		return setconfigparam(best, step.dim, choice);
+	}
+	unsigned int partnerValues = GLOB_dimensioncardinality[step.partner];
+	return setconfigparam(setconfigparam(best, step.dim, choice / partnerValues),
+			step.partner, choice % partnerValues);
+}
 
 /*
  * Given a half-baked configuration containing cache properties, generate
@@ -50,63 +111,12 @@ std::string generateCacheLatencyParams(string halfBackedConfig) {
 
     std::stringstream latencySettings;
 
-	// L1 Data Cache Size and Associativity 
-    int dl1Size = getdl1size(halfBackedConfig);
-    unsigned int dl1Assoc = 1 << extractConfigPararm(halfBackedConfig, 4);
-
-	// L1 Instruction Cache Size and Associativity 
-    int il1Size = getil1size(halfBackedConfig);
-    unsigned int il1Assoc = 1 << extractConfigPararm(halfBackedConfig, 6);
-
-	// L2 Unified Cache Size and Associativity 
-    int ul2Size = getl2size(halfBackedConfig);
-    unsigned int ul2Assoc = 1 << extractConfigPararm(halfBackedConfig, 9);
+	// Latency grows with log2 of the size in KB and log2 of the associativity;
+	// indices as defined in runprojectsuite.sh.
+	ConfigId latencies = setcachelatencies(packconfiguration(halfBackedConfig));
 
-	// Calculating latencies (without considering associativity)
-    int dl1Lat = log2(dl1Size / KILOBYTE);
-    int il1Lat = log2(il1Size / KILOBYTE);
-    int ul2Lat = log2(ul2Size / KILOBYTE);
-	
-	/* DEBUG
-    cout << "__________________________________________\n";
-	cout << "dl1Size (KB): " << dl1Size / KILOBYTE << "\n";
-	cout << "dl1Assoc: " << dl1Assoc << "\n";
-	cout << "dl1Lat (initial): " << dl1Lat<< "\n\n";
-
-    cout << "__________________________________________\n";
-	cout << "il1Size (KB): " << il1Size / KILOBYTE << "\n";
-	cout << "il1Assoc: " << il1Assoc << "\n";
-	cout << "il1Lat (initial): " << il1Lat<< "\n\n";
-
-    cout << "__________________________________________\n";
-	cout << "ul2Size (KB): " << ul2Size / KILOBYTE << "\n";
-	cout << "ul2Assoc: " << ul2Assoc << "\n";
-	cout << "ul2Lat (initial): " << ul2Lat<< "\n\n";
-	*/
-
-	// Adding additional latency cycles due to associativity
-	dl1Lat += log2(dl1Assoc);
-	il1Lat += log2(il1Assoc);
-	ul2Lat += log2(ul2Assoc); 
-	 
-	/* DEBUG
-	cout << "dl1Lat (final): " << dl1Lat << "\n";
-	cout << "il1Lat (final): " << il1Lat << "\n";
-	cout << "ul2Lat (final): " << ul2Lat << "\n\n";
-	*/
-
-	// Conversions of latencies to corresponding indices as defined in runprojectsuite.sh
-	int dl1LatIndex = dl1Lat - 1;
-	int il1LatIndex = il1Lat - 1;
-	int ul2LatIndex = ul2Lat - 5;
-
-	/* DEBUG
-	cout << "dl1LatIndex: " << dl1LatIndex << "\n";
-	cout << "il1LatIndex: " << il1LatIndex << "\n";
-	cout << "ul2LatIndex: " << ul2LatIndex << "\n\n";
-	*/
-
-    latencySettings << dl1LatIndex << " " << il1LatIndex << " " << ul2LatIndex;
+    latencySettings << configparam(latencies, 15) << " "
+    		<< configparam(latencies, 16) << " " << configparam(latencies, 17);
 
     return latencySettings.str();
 }
@@ -116,45 +126,114 @@ std::string generateCacheLatencyParams(string halfBackedConfig) {
  */
 int validateConfiguration(std::string configuration) {
 
-    // the BLOCK sizes of L1 instruction & data caches and unified cache
-    unsigned int dl1BlockSize = 8 * (1 << extractConfigPararm(configuration, 2));
-    unsigned int il1BlockSize = 8 * (1 << extractConfigPararm(configuration, 2));
-    unsigned int ul2BlockSize = 16 << extractConfigPararm(configuration, 8);
+    // Block size relations, L1/L2 size windows and ul2 >= 2 * (il1 + dl1)
+    // live with the design space, see 431projectSpace.cpp.
+    if (!isvalidconfiguration(packconfiguration(configuration)))
+    	return 0;
 
-    // The (OVERALL) sizes of L1 instruction & data caches and unified cache
-    unsigned int dl1Size = getdl1size(configuration);
-    unsigned int il1Size = getil1size(configuration);
-    unsigned int ul2Size = getl2size(configuration);
+    // The below is a necessary, but insufficient condition for validating a
+    // configuration.
+    return isNumDimConfiguration(configuration);
+}
 
-    // instruction fetch queue
-    int ifq = 1 << extractConfigPararm(configuration, 0);
+/*
+ * Best configuration for the current optimisation target.
+ */
+static ConfigId bestconfiguration(std::string bestEXECconfiguration,
+		std::string bestEDPconfiguration, int optimizeforEXEC,
+		int optimizeforEDP) {
+	string bestConfig;
+	if (optimizeforEXEC == 1)
+		bestConfig = bestEXECconfiguration;
 
-    // Case 1: the L1 instruction cache block size must be at least the instruction fetch queue size 
-    // Also, the L1 data cache should have the same block size as the L1 instruction cache
-    if ((il1BlockSize < ifq) || (il1BlockSize != dl1BlockSize))
-    	return 0;
-    
-    // Case 2: unified L2 cache block size must be at least twice the il1 block size 
-    // but a max of 128 bytes
-    // Also ul2 overall size must be at least twice the overall sizes of il1 + dl1
-    if ( ((ul2BlockSize < (2 * il1BlockSize)) 
-        || (ul2BlockSize > 128))
-        || (ul2Size < 2 *(il1Size + dl1Size)) )
-    	return 0;
+	if (optimizeforEDP == 1)
+		bestConfig = bestEDPconfiguration;
 
-    // Case 3: il1 and dl1 sizes must be a minimum of 2 KB and maximum of 64 KB
-    if ((il1Size < 2*KILOBYTE) || (il1Size > 64*KILOBYTE))
-    	return 0;
-    if ((dl1Size < 2*KILOBYTE) || (dl1Size > 64*KILOBYTE))
-        return 0;
+	return packconfiguration(bestConfig);
+}
+
+/*
+ * Restarts the traversal in state at its first step. Only the real traversal
+ * asks the planner for a new plan; a lookahead copy keeps the one it has.
+ */
+static void starttraversal(ExplorerState& state, ConfigId best) {
+	std::vector<SweepStep> plan = sweepPlan;
+	if (sweepPlanner && &explorer == &state && sweepPlanner(best, plan)
+			&& !plan.empty()) {
+		sweepPlan = plan;
+	}
+	state.dimensionIndex = 0;
+	state.currentlyExploringDim = sweepPlan[state.dimensionIndex].dim;
+	state.choiceIndex = 0;
+	state.currentDimDone = false;
+}
 
-    // Case 4: ul2 size must be a minimum of 32 KB and maximum of 1024 KB
-    if ((ul2Size < 32*KILOBYTE) || (ul2Size > 1024*KILOBYTE))
-        return 0;
+/*
+ * Advances the traversal in state to the next valid configuration that is
+ * neither seen nor in assumedseen. Returns NO_CONFIG once the DSE is complete.
+ */
+static ConfigId proposeconfiguration(ExplorerState& state, ConfigId best,
+		const std::vector<ConfigId>& assumedseen) {
+	ConfigId nextconfiguration;
 
-    // The below is a necessary, but insufficient condition for validating a
-    // configuration.
-    return isNumDimConfiguration(configuration);
+	// Continue if proposed configuration is invalid or has been seen/checked before.
+	do {
+		// Check if DSE has been completed before.
+		if (state.isDSEComplete) {
+			return NO_CONFIG;
+		}
+
+		// choiceIndex holds the index for the value in the array for the current dimension
+		// dimensionIndex holds the index of the current dimension in the order
+		// currentlyExploringDim holds the value for the current dimension being explored
+
+		const SweepStep& step = sweepPlan[state.dimensionIndex];
+		if (state.choiceIndex >= (int) sweepsize(step)) {
+			state.choiceIndex = sweepsize(step) - 1;
+			state.currentDimDone = true;
+		}
+
+		// Every other independent dimension keeps its already-selected best
+		// value. The last NUM_DIMS_DEPENDENT parameters depend on the cache
+		// geometry and are derived from it.
+		nextconfiguration = setcachelatencies(
+				sweeppoint(best, step, state.choiceIndex));
+		state.choiceIndex++;
+
+		// Make sure we start exploring next dimension in next iteration.
+		if (state.currentDimDone) {
+			if (++state.dimensionIndex < (int) sweepPlan.size())
+				state.currentlyExploringDim = sweepPlan[state.dimensionIndex].dim;
+			state.choiceIndex = 0;
+			state.currentDimDone = false;
+		}
+
+		// Creating cases to determine if the DSE is done or not
+		if (state.dimensionIndex >= (int) sweepPlan.size()) {
+			if (state.traversalIndex == 0) { // First traversal 
+				state.bestTraversalConfig = nextconfiguration;
+				state.traversalIndex++;
+				
+				// Reset global variables
+				starttraversal(state, best);
+			} else {
+				if (nextconfiguration == state.bestTraversalConfig) { // The best traversal has been ensured by consecutive runs producing same result
+					state.isDSEComplete = true;
+				} else {
+					state.bestTraversalConfig = nextconfiguration;
+
+					// Reset global variables
+					starttraversal(state, best);
+					state.traversalIndex++;
+				}
+			}
+		}
+	} while (!isvalidconfiguration(nextconfiguration)
+			|| isconfigurationseen(nextconfiguration)
+			|| assumedseen.end()
+					!= std::find(assumedseen.begin(), assumedseen.end(),
+							nextconfiguration));
+	return nextconfiguration;
 }
 
 /*
@@ -184,115 +263,93 @@ std::string generateNextConfigurationProposal(std::string currentconfiguration,
 	// 2. GLOB_baseline
 	// 3. NUM_DIMS
 	// 4. NUM_DIMS_DEPENDENT
-	// 5. GLOB_seen_configurations
-
-	/*
-    cout << "__________________________________________\n";
-    cout << "PRIOR TO WHILE LOOP: \n";
-    cout << "choiceIndex: " << choiceIndex << "\n";
-    cout << "nextconfiguration: " << currentconfiguration << "\n";
-    cout << "currentlyExploringDim: " << currentlyExploringDim << "\n";
-    cout << "Dimension name: " << GLOB_dimensionnames[currentlyExploringDim] << "\n";
-    cout << "__________________________________________\n";
-    cout << "\n\n";
-	*/
-
-	std::string nextconfiguration = currentconfiguration;
-	// Continue if proposed configuration is invalid or has been seen/checked before.
-	while (!validateConfiguration(nextconfiguration) || GLOB_seen_configurations[nextconfiguration]) {
-		
-		/* Debugging print statements
-        cout << "choiceIndex: " << choiceIndex << "\n";
-        cout << "nextconfiguration: " << currentconfiguration << "\n";
-        cout << "currentlyExploringDim: " << currentlyExploringDim << "\n";
-        cout << "Dimension name: " << GLOB_dimensionnames[currentlyExploringDim] << "\n";
-        cout << "\n";
-		*/ 
-
-		// Check if DSE has been completed before and return current
-		// configuration.
-		if(isDSEComplete) {
-			return currentconfiguration;
-		}
-
-		std::stringstream ss;
-
-		string bestConfig;
-		if (optimizeforEXEC == 1)
-			bestConfig = bestEXECconfiguration;
+	// 5. isconfigurationseen()
 
-		if (optimizeforEDP == 1)
-			bestConfig = bestEDPconfiguration;
-
-		// Fill in the dimensions already-scanned with the already-selected best
-		// value.
-		for (int dim = 0; dim < currentlyExploringDim; ++dim) {
-			ss << extractConfigPararm(bestConfig, dim) << " ";
-		}
-
-		// choiceIndex holds the index for the value in the array for the current dimension
-		// dimensionIndex holds the index of the current dimension in the order
-		// currentlyExploringDim holds the value for the current dimension being explored
-		
-		if (choiceIndex >= GLOB_dimensioncardinality[currentlyExploringDim]) {
-			choiceIndex = GLOB_dimensioncardinality[currentlyExploringDim] - 1;
-			currentDimDone = true;
-		} 
-
-		ss << choiceIndex << " ";
-		choiceIndex++;
-
-		// Fill in remaining independent params with 0.
-		for (int dim = (currentlyExploringDim + 1); dim < (NUM_DIMS - NUM_DIMS_DEPENDENT); ++dim) {
-			ss << extractConfigPararm(bestConfig, dim) << " ";
-		}
-
-		//
-		// Last NUM_DIMS_DEPENDENT3 configuration parameters are not independent.
-		// They depend on one or more parameters already set. Determine the
-		// remaining parameters based on already decided independent ones.
-		//
-		string configSoFar = ss.str();
-
-		// Populate this object using corresponding parameters from config.
-		ss << generateCacheLatencyParams(configSoFar);
+	if (validateConfiguration(currentconfiguration)
+			&& !isconfigurationseen(packconfiguration(currentconfiguration))) {
+		return currentconfiguration;
+	}
 
-		// Configuration is ready now.
-		nextconfiguration = ss.str();
+	ConfigId next = proposeconfiguration(explorer,
+			bestconfiguration(bestEXECconfiguration, bestEDPconfiguration,
+					optimizeforEXEC, optimizeforEDP), std::vector<ConfigId>());
+	// Return the current configuration once the DSE is complete.
+	return (NO_CONFIG == next) ? currentconfiguration : unpackconfiguration(next);
+}
 
-		// Make sure we start exploring next dimension in next iteration.
-		if (currentDimDone) {
-			currentlyExploringDim = order[++dimensionIndex];
-			choiceIndex = 0;
-			currentDimDone = false;
+/*
+ * Works out the proposals that would follow nextconfiguration if the best
+ * configurations do not change, on a copy of the heuristic progress.
+ */
+void peekConfigurationProposals(std::string nextconfiguration,
+		std::string bestEXECconfiguration, std::string bestEDPconfiguration,
+		int optimizeforEXEC, int optimizeforEDP, unsigned int count,
+		std::vector<std::string>& proposals) {
+	ExplorerState lookahead = explorer;
+	ConfigId best = bestconfiguration(bestEXECconfiguration,
+			bestEDPconfiguration, optimizeforEXEC, optimizeforEDP);
+	// nextconfiguration will have been seen by the time the real search moves on
+	std::vector<ConfigId> assumedseen(1, packconfiguration(nextconfiguration));
+	while (proposals.size() < count) {
+		ConfigId next = proposeconfiguration(lookahead, best, assumedseen);
+		if (NO_CONFIG == next) {
+			break;
 		}
+		assumedseen.push_back(next);
+		proposals.push_back(unpackconfiguration(next));
+	}
+}
 
-		// Creating cases to determine if the DSE is done or not
-		if (dimensionIndex >= (NUM_DIMS - NUM_DIMS_DEPENDENT)) {
-			if (traversalIndex == 0) { // First traversal 
-				bestTraversalConfig = nextconfiguration;
-				traversalIndex++;
-				
-				// Reset global variables
-				dimensionIndex = 0;
-				currentlyExploringDim = order[dimensionIndex];
-				choiceIndex = 0;
-				currentDimDone = false;
-			} else {
-				if (nextconfiguration == bestTraversalConfig) { // The best traversal has been ensured by consecutive runs producing same result
-					isDSEComplete = true;
-				} else {
-					bestTraversalConfig = nextconfiguration;
+/*
+ * The heuristic progress as one line of text, and back; the sweep plan
+ * follows as its length and the dimension and partner of every step. Lines
+ * journaled without a plan keep the current one.
+ */
+std::string saveExplorerState() {
+	std::stringstream state;
+	state << explorer.dimensionIndex << " " << explorer.choiceIndex << " "
+			<< explorer.traversalIndex << " " << explorer.currentDimDone << " "
+			<< explorer.isDSEComplete << " " << explorer.currentlyExploringDim
+			<< " " << explorer.bestTraversalConfig << " " << sweepPlan.size();
+	for (size_t s = 0; s < sweepPlan.size(); ++s) {
+		state << " " << sweepPlan[s].dim << " " << sweepPlan[s].partner;
+	}
+	return state.str();
+}
 
-					// Reset global variables
-					dimensionIndex = 0;
-					currentlyExploringDim = order[dimensionIndex];
-					choiceIndex = 0;
-					currentDimDone = false;
-					traversalIndex++;
-				}
+int restoreExplorerState(std::string line) {
+	std::stringstream state(line);
+	ExplorerState restored;
+	if (!(state >> restored.dimensionIndex >> restored.choiceIndex
+			>> restored.traversalIndex >> restored.currentDimDone
+			>> restored.isDSEComplete >> restored.currentlyExploringDim
+			>> restored.bestTraversalConfig)
+			|| restored.currentlyExploringDim >= NUM_DIMS) {
+		return 0;
+	}
+	std::vector<SweepStep> plan = sweepPlan;
+	size_t steps;
+	if (state >> steps) {
+		plan.resize(steps);
+		for (size_t s = 0; s < steps; ++s) {
+			if (!(state >> plan[s].dim >> plan[s].partner)
+					|| plan[s].dim < 0
+					|| plan[s].dim >= NUM_DIMS - NUM_DIMS_DEPENDENT
+					|| plan[s].partner >= NUM_DIMS - NUM_DIMS_DEPENDENT) {
+				return 0;
 			}
 		}
 	}
-	return nextconfiguration;
-}
\ No newline at end of file
+	// A step of the plan, and a choice of it or one past its last.
+	if (plan.empty() || restored.dimensionIndex < 0
+			|| restored.dimensionIndex >= (int) plan.size()
+			|| restored.choiceIndex < 0
+			|| restored.choiceIndex
+					> (int) sweepsize(plan[restored.dimensionIndex])
+			|| restored.traversalIndex < 0) {
+		return 0;
+	}
+	sweepPlan = plan;
+	explorer = restored;
+	return 1;
+}
@@ -104,6 +104,26 @@ dl1lat_index=${16}
 il1lat_index=${17}
 ul2lat_index=${18}
 
+#
+# Optional 19th argument: run only this benchmark. The caller is then
+# responsible for marking the configuration as simulated.
+#
+bench_index=${19}
+
+#
+# Optional 20th argument "ptrace": also write a pipetrace of each run to
+# rawProjectOutputData/<benchmark>.<configuration>.ptrace, which DSE reduces
+# to reference and branch traces for its cache and branch predictor estimates.
+#
+capture=${20}
+
+#
+# Optional 21st argument: instructions to simulate instead of the full window,
+# for screening runs. Their results go to rawProjectOutputData/<instructions>/
+# so they never mix with full runs.
+#
+window=${21}
+
 echo ${1} ${width[$width_index]}
 echo ${2} ${scheduling[$scheduling_index]}
 echo ${3} ${l1block[$l1block_index]}
@@ -112,8 +132,86 @@ echo ${4} ${dl1sets[$dl1sets_index]}
 # Execute SimpleScalar simulator for each benchmark using the system defined by paramaters passed to this script.
 #
 
-for benchnum in $(seq 0 $((${#benchpairs[*]} - 1))) ; do
-    eval /home/software/simplescalar/x86_64/bin/sim-outorder -fastfwd 10000000 -max:inst 1000000 \
+if [ -n "$bench_index" ] ; then
+    benchlist=$bench_index
+else
+    benchlist=$(seq 0 $((${#benchpairs[*]} - 1)))
+fi
+
+#
+# Fast-forward checkpoints, shared by every configuration. sim-eio emulates the
+# fast-forward phase of a benchmark once and saves the architectural state at
+# its end, with the I/O of the window after it, in checkpoints/<benchmark>.eio;
+# sim-outorder then starts from there instead of fast-forwarding again. The
+# .stamp next to it holds the checksum of the benchmark binary, its inputs and
+# the generating command, followed by that of the .eio itself. A checkpoint is
+# used only if both still match and is regenerated otherwise; runs fall back
+# to -fastfwd if that fails.
+#
+simdir=/home/software/simplescalar/x86_64/bin
+fastfwd=10000000
+fullinst=1000000
+maxinst=${window:-$fullinst}
+eioinst=$((2 * fullinst)) # measured window plus room for in-flight instructions
+chkptdir=checkpoints
+outdir=rawProjectOutputData${window:+/$window}
+mkdir -p $outdir
+
+checkpoint_sum() {
+    local words=( ${benchpairs[$1]} ) word
+    {
+        echo sim-eio -fastfwd $fastfwd -max:inst $eioinst ${benchpairs[$1]}
+        for word in "${words[@]}" ; do
+            [ -f "$word" ] && cksum < "$word"
+        done
+    } | cksum
+}
+
+checkpoint_valid() {
+    [ -f "$chkptdir/$1.eio" ] && [ -f "$chkptdir/$1.stamp" ] &&
+        [ "$(cat "$chkptdir/$1.stamp")" = "$2 $(cksum < "$chkptdir/$1.eio")" ]
+}
+
+#
+# Makes sure checkpoints/<benchmark>.eio is current. Concurrent runs of the
+# same benchmark wait for the one generating it.
+#
+checkpoint() {
+    local sum eio=$chkptdir/$1.eio
+    sum=$(checkpoint_sum $1)
+    checkpoint_valid $1 "$sum" && return 0
+    [ -x $simdir/sim-eio ] && mkdir -p $chkptdir || return 1
+    (
+        flock 9
+        checkpoint_valid $1 "$sum" && exit 0
+        rm -f "$chkptdir/$1.stamp"
+        eval $simdir/sim-eio -fastfwd $fastfwd -max:inst $eioinst \
+            -trace "$eio.tmp" -redir:sim "$chkptdir/$1.log" \
+            ${benchpairs[$1]} && mv "$eio.tmp" "$eio" &&
+            echo "$sum $(cksum < "$eio")" > "$chkptdir/$1.stamp"
+    ) 9> "$eio.lock"
+    checkpoint_valid $1 "$sum"
+}
+
+#
+# Each run writes its statistics to a file of its own and renames it into
+# place once the run succeeded, so readers, DSE processes on other hosts
+# among them, never see a partial .simout. A run cut short by a signal
+# removes its part file on the way out; the DSE job pool removes those of
+# runs it killed outright.
+#
+status=0
+trap 'rm -f "$part"' EXIT
+trap 'exit 143' TERM INT
+for benchnum in $benchlist ; do
+    simout=$outdir/"$benchnum"."${1}"."${2}"."${3}"."${4}"."${5}"."${6}"."${7}"."${8}"."${9}"."${10}"."${11}"."${12}"."${13}"."${14}"."${15}"."${16}"."${17}"."${18}".simout
+    part=$simout.$(hostname).$$.part
+    if checkpoint $benchnum ; then
+        program="-max:inst $maxinst $chkptdir/$benchnum.eio"
+    else
+        program="-fastfwd $fastfwd -max:inst $maxinst ${benchpairs[$benchnum]}"
+    fi
+    eval $simdir/sim-outorder \
         -fetch:ifqsize ${width[$width_index]} \
         -fetch:speed 1 -fetch:mplat 3 \
         -decode:width ${width[$width_index]} \
@@ -136,11 +234,15 @@ for benchnum in $(seq 0 $((${#benchpairs[*]} - 1))) ; do
         ${branchsettings[${branchsettings_index}]} \
         -bpred:ras ${ras[$ras_index]} \
         -bpred:btb ${btb[$btb_index]} \
-        -redir:sim rawProjectOutputData/"$benchnum"."${1}"."${2}"."${3}"."${4}"."${5}"."${6}"."${7}"."${8}"."${9}"."${10}"."${11}"."${12}"."${13}"."${14}"."${15}"."${16}"."${17}"."${18}".simout \
-        ${benchpairs[$benchnum]}
+        ${capture:+-ptrace rawProjectOutputData/"$benchnum"."${1}"."${2}"."${3}"."${4}"."${5}"."${6}"."${7}"."${8}"."${9}"."${10}"."${11}"."${12}"."${13}"."${14}"."${15}"."${16}"."${17}"."${18}".ptrace :} \
+        -redir:sim "$part" \
+        $program && mv -f "$part" "$simout" || status=$?
+    rm -f "$part"
 done
 
 #
 # Make note in a file that this configuration has been simulated.
 # 
-touch rawProjectOutputData/DONE."${1}"."${2}"."${3}"."${4}"."${5}"."${6}"."${7}"."${8}"."${9}"."${10}"."${11}"."${12}"."${13}"."${14}"."${15}"."${16}"."${17}"."${18}".DONE
+[ -n "$bench_index" ] || [ -n "$window" ] || touch rawProjectOutputData/DONE."${1}"."${2}"."${3}"."${4}"."${5}"."${6}"."${7}"."${8}"."${9}"."${10}"."${11}"."${12}"."${13}"."${14}"."${15}"."${16}"."${17}"."${18}".DONE
+
+exit $status